@@ -0,0 +1,165 @@
+#include "businessdays.h"
+#include "calendar.h"
+#include <algorithm>
+#include <bit>
+
+static constexpr int MIN_COVERAGE_DAYS = 4 * 366;
+
+static int weekdayOf(int dayNumber) {
+    return Date::fromDayNumber(dayNumber).getDayOfWeekNumber();
+}
+
+BusinessCalendar::BusinessCalendar() : weekendMask((1 << 0) | (1 << 6)) {
+}
+
+void BusinessCalendar::invalidate() {
+    words.clear();
+    prefix.clear();
+}
+
+bool BusinessCalendar::setWeekend(int weekday, bool isWeekend) {
+    if (weekday < 0 || weekday > 6) {
+        return false;
+    }
+
+    const std::uint8_t mask = isWeekend
+        ? static_cast<std::uint8_t>(weekendMask | (1 << weekday))
+        : static_cast<std::uint8_t>(weekendMask & ~(1 << weekday));
+    if (mask == 0x7F) {
+        return false;
+    }
+    if (mask != weekendMask) {
+        weekendMask = mask;
+        invalidate();
+    }
+    return true;
+}
+
+int BusinessCalendar::getWorkingDaysPerWeek() const {
+    return 7 - std::popcount(static_cast<unsigned>(weekendMask));
+}
+
+void BusinessCalendar::addHoliday(const Date& date) {
+    if (holidays.insert(date.toDayNumber()).second) {
+        invalidate();
+    }
+}
+
+bool BusinessCalendar::removeHoliday(const Date& date) {
+    if (holidays.erase(date.toDayNumber()) == 0) {
+        return false;
+    }
+    invalidate();
+    return true;
+}
+
+void BusinessCalendar::addHolidays(const Calendar& calendar, const Date& from, const Date& to) {
+    for (const Event& event : calendar.getEventsByType(EventType::HOLIDAY, from, to)) {
+        addHoliday(event.getDate());
+    }
+}
+
+// Rebuilds the bitmap so it covers [fromDay, toDay], growing by at least half
+// its current size on each side so repeated extension stays amortised.
+void BusinessCalendar::ensureCovers(int fromDay, int toDay) const {
+    const int coveredEnd = firstDay + static_cast<int>(words.size()) * 64;
+    if (!words.empty() && fromDay >= firstDay && toDay < coveredEnd) {
+        return;
+    }
+
+    int newFirst = words.empty() ? fromDay : std::min(fromDay, firstDay);
+    int newEnd = words.empty() ? toDay + 1 : std::max(toDay + 1, coveredEnd);
+    const int pad = std::max(MIN_COVERAGE_DAYS, (newEnd - newFirst) / 2);
+    newFirst -= pad;
+    newEnd += pad;
+
+    const std::size_t wordCount = static_cast<std::size_t>(newEnd - newFirst + 63) / 64;
+    words.assign(wordCount, 0);
+
+    // Weekends repeat every 7 days, so lay the weekday pattern out bit by bit.
+    int weekday = weekdayOf(newFirst);
+    for (std::size_t bit = 0; bit < wordCount * 64; bit++) {
+        if (!isWeekend(weekday)) {
+            words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+        weekday = weekday == 6 ? 0 : weekday + 1;
+    }
+
+    const int end = newFirst + static_cast<int>(wordCount) * 64;
+    for (auto it = holidays.lower_bound(newFirst); it != holidays.end() && *it < end; ++it) {
+        const int bit = *it - newFirst;
+        words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+    }
+
+    prefix.resize(wordCount + 1);
+    prefix[0] = 0;
+    for (std::size_t i = 0; i < wordCount; i++) {
+        prefix[i + 1] = prefix[i] + std::popcount(words[i]);
+    }
+    firstDay = newFirst;
+}
+
+// Working days in [firstDay, dayNumber).
+std::int64_t BusinessCalendar::rank(int dayNumber) const {
+    const int offset = dayNumber - firstDay;
+    const std::size_t word = static_cast<std::size_t>(offset) / 64;
+    const int bit = offset % 64;
+    if (word == words.size()) {
+        return prefix.back();
+    }
+    return prefix[word] + std::popcount(words[word] & ((std::uint64_t(1) << bit) - 1));
+}
+
+// Day number of the working day with the given zero-based rank.
+int BusinessCalendar::select(std::int64_t index) const {
+    const std::size_t word = (std::upper_bound(prefix.begin(), prefix.end(), index) - prefix.begin()) - 1;
+    std::uint64_t bits = words[word];
+    for (std::int64_t skip = index - prefix[word]; skip > 0; skip--) {
+        bits &= bits - 1;
+    }
+    return firstDay + static_cast<int>(word) * 64 + std::countr_zero(bits);
+}
+
+bool BusinessCalendar::isBusinessDay(const Date& date) const {
+    const int day = date.toDayNumber();
+    return !isWeekend(date.getDayOfWeekNumber()) && holidays.find(day) == holidays.end();
+}
+
+int BusinessCalendar::countBusinessDays(const Date& from, const Date& to) const {
+    const int a = from.toDayNumber();
+    const int b = to.toDayNumber();
+    ensureCovers(std::min(a, b), std::max(a, b));
+    return static_cast<int>(rank(b) - rank(a));
+}
+
+Date BusinessCalendar::addBusinessDays(const Date& start, int days) const {
+    const int day = start.toDayNumber();
+    if (days == 0) {
+        return start;
+    }
+
+    // Start with a span that holds the target when there are no holidays and
+    // keep growing it while holidays push the target further out.
+    const int reach = static_cast<int>(std::min<std::int64_t>(std::int64_t(days < 0 ? -days : days) * 7 / getWorkingDaysPerWeek() + 14, 1 << 24));
+    if (days > 0) {
+        int to = day + reach;
+        for (;;) {
+            ensureCovers(day, to);
+            const std::int64_t target = rank(day + 1) + days - 1;
+            if (target < prefix.back()) {
+                return Date::fromDayNumber(select(target));
+            }
+            to = firstDay + static_cast<int>(words.size()) * 64;
+        }
+    }
+
+    int from = day - reach;
+    for (;;) {
+        ensureCovers(from, day);
+        const std::int64_t target = rank(day) + days;
+        if (target >= 0) {
+            return Date::fromDayNumber(select(target));
+        }
+        from = firstDay - 1;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef BUSINESSDAYS_H
+#define BUSINESSDAYS_H
+
+#include "datetime.h"
+#include <cstdint>
+#include <set>
+#include <vector>
+
+class Calendar;
+
+// Working-day arithmetic over weekends and holidays. Working days are kept as
+// a bitmap over a contiguous span of day numbers, with the number of working
+// days before each 64-bit word, so counting is O(1) and "N working days from
+// X" is a binary search over those prefixes. The span grows on demand; that
+// growth happens inside const queries, so an instance must not be queried from
+// several threads at once.
+class BusinessCalendar {
+private:
+    std::uint8_t weekendMask;  // bit i set: weekday i (0 = Sunday) is not worked
+    std::set<int> holidays;    // day numbers
+
+    mutable int firstDay = 0;
+    mutable std::vector<std::uint64_t> words;
+    mutable std::vector<std::int64_t> prefix;  // working days before each word, plus the total
+
+    void invalidate();
+    void ensureCovers(int fromDay, int toDay) const;
+    std::int64_t rank(int dayNumber) const;
+    int select(std::int64_t index) const;
+
+public:
+    // Saturdays and Sundays off, no holidays.
+    BusinessCalendar();
+
+    // Returns false, leaving the calendar unchanged, if it would make every
+    // day of the week a weekend.
+    bool setWeekend(int weekday, bool isWeekend);
+    bool isWeekend(int weekday) const { return (weekendMask >> weekday) & 1; }
+    int getWorkingDaysPerWeek() const;
+
+    void addHoliday(const Date& date);
+    bool removeHoliday(const Date& date);
+    // Adds the date of every EventType::HOLIDAY event in [from, to],
+    // including the occurrences of recurring holidays.
+    void addHolidays(const Calendar& calendar, const Date& from, const Date& to);
+
+    bool isBusinessDay(const Date& date) const;
+    // Working days in [from, to); negative if to is before from.
+    int countBusinessDays(const Date& from, const Date& to) const;
+    // The days-th working day after start (before it if days is negative).
+    // Zero returns start unchanged.
+    Date addBusinessDays(const Date& start, int days) const;
+};
+
+#endif
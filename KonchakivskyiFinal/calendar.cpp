@@ -1,33 +1,27 @@
 #include "calendar.h"
+#include "businessdays.h"
+#include "daterange.h"
+#include "eventquery.h"
 #include <iostream>
-#include <iomanip>
 #include <algorithm>
+#include <iterator>
 
 Event::Event(const Date& date, const std::string& title,
     EventType type, EventPriority priority,
     const std::string& description)
-    : date(date), hasTime(false), type(type), priority(priority),
+    : when(date), type(type), priority(priority),
     title(title), description(description) {
-    time = Time(0, 0, 0);
 }
 
 Event::Event(const Date& date, const Time& time, const std::string& title,
     EventType type, EventPriority priority,
     const std::string& description)
-    : date(date), time(time), hasTime(true), type(type), priority(priority),
+    : when(date, time), type(type), priority(priority),
     title(title), description(description) {
 }
 
 bool Event::operator<(const Event& other) const {
-    if (date != other.date) {
-        return date < other.date;
-    }
-
-    if (hasTime && other.hasTime) {
-        return time < other.time;
-    }
-
-    return hasTime < other.hasTime;
+    return when < other.when;
 }
 
 bool Event::operator>(const Event& other) const {
@@ -35,9 +29,7 @@ bool Event::operator>(const Event& other) const {
 }
 
 bool Event::operator==(const Event& other) const {
-    if (date != other.date) return false;
-    if (hasTime != other.hasTime) return false;
-    if (hasTime && time != other.time) return false;
+    if (when != other.when) return false;
     if (title != other.title) return false;
     return true;
 }
@@ -70,38 +62,56 @@ void Event::display() const {
 }
 
 std::string Event::toString() const {
-    std::string result = date.toString();
-    if (hasTime) {
-        result += " " + time.toString();
+    char buffer[Date::FORMAT_SIZE + 1 + Time::FORMAT_SIZE];
+    char* end = when.getDate().formatTo(buffer);
+    if (when.hasTime()) {
+        *end++ = ' ';
+        end = when.getTime().formatTo(end);
     }
-    result += " | " + title + " | " + eventTypeToString(type) +
-        " | " + eventPriorityToString(priority);
+
+    const std::string typeName = eventTypeToString(type);
+    const std::string priorityName = eventPriorityToString(priority);
+
+    std::string result;
+    result.reserve((end - buffer) + title.size() + typeName.size() + priorityName.size() + description.size() + 12);
+    result.append(buffer, end);
+    result += " | ";
+    result += title;
+    result += " | ";
+    result += typeName;
+    result += " | ";
+    result += priorityName;
     if (!description.empty()) {
-        result += " | " + description;
+        result += " | ";
+        result += description;
     }
     return result;
 }
 
-std::ostream& operator<<(std::ostream& os, const Event& event) {
-    os << event.date;
-    if (event.hasTime) {
-        os << " " << event.time;
+void Event::renderTo(RenderBuffer& out) const {
+    out.appendDate(when.getDate());
+    if (when.hasTime()) {
+        out << ' ';
+        out.appendTime(when.getTime());
     }
     else {
-        os << " (All day)";
+        out << " (All day)";
     }
 
-    os << " | " << event.title
-        << " | Type: " << Event::eventTypeToString(event.type)
-        << " | Priority: " << Event::eventPriorityToString(event.priority);
+    out << " | " << title
+        << " | Type: " << eventTypeToString(type)
+        << " | Priority: " << eventPriorityToString(priority);
 
-    if (!event.description.empty()) {
-        os << " | Description: " << event.description;
+    if (!description.empty()) {
+        out << " | Description: " << description;
     }
-
-    return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const Event& event) {
+    RenderBuffer out;
+    event.renderTo(out);
+    return os.write(out.str().data(), static_cast<std::streamsize>(out.size()));
+}
 
 Calendar::Calendar() : currentViewDate() {
 }
@@ -109,22 +119,471 @@ Calendar::Calendar() : currentViewDate() {
 Calendar::Calendar(const Date& initialViewDate) : currentViewDate(initialViewDate) {
 }
 
-void Calendar::addEvent(const Event& event) {
-    events.push_back(event);
-    std::sort(events.begin(), events.end());
+// Compaction runs once tombstones are this share of the rows, so its linear
+// cost is spread over at least that many removals.
+static constexpr std::size_t COMPACT_MIN_DEAD = 1024;
+static constexpr std::size_t COMPACT_DEAD_DIVISOR = 4;
+
+std::uint32_t Calendar::allocateSlot(std::uint32_t row) {
+    std::uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<std::uint32_t>(slots.size());
+        slots.push_back(Slot{ FREE, 0 });
+    }
+    slots[slot].row = row;
+    return slot;
+}
+
+void Calendar::releaseSlot(std::uint32_t slot) {
+    slots[slot].row = FREE;
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
+}
+
+std::uint32_t Calendar::resolve(const EventId& id) const {
+    if (id.slot >= slots.size() || slots[id.slot].generation != id.generation || slots[id.slot].row == FREE) {
+        return FREE;
+    }
+    return id.slot;
+}
+
+void Calendar::summarize(const Event& event) {
+    daySummaries.add(event.getDate(), static_cast<std::uint8_t>(event.getPriority()), event.getHasTime());
+}
+
+void Calendar::unsummarize(const Event& event) {
+    daySummaries.remove(event.getDate(), static_cast<std::uint8_t>(event.getPriority()), event.getHasTime());
+}
+
+EventId Calendar::addEvent(const Event& event) {
+    if (sortingDeferred) {
+        const std::uint32_t slot = allocateSlot(PENDING | static_cast<std::uint32_t>(pendingEvents.size()));
+        pendingEvents.push_back(event);
+        pendingSlots.push_back(slot);
+        return EventId(slot, slots[slot].generation);
+    }
+    // Equal dates and times keep the order they were added in.
+    const auto& keys = columns.getKeys();
+    const std::size_t row = std::upper_bound(keys.begin(), keys.end(), event.getDateTime().getValue()) - keys.begin();
+    events.insert(events.begin() + row, event);
+    columns.insert(row, event.getDateTime().getValue(), static_cast<std::uint8_t>(event.getType()),
+        static_cast<std::uint8_t>(event.getPriority()), event.getTitle());
+
+    const std::uint32_t slot = allocateSlot(static_cast<std::uint32_t>(row));
+    rowSlots.insert(rowSlots.begin() + row, slot);
+    for (std::size_t later = row + 1; later < rowSlots.size(); later++) {
+        if (rowSlots[later] != FREE) {
+            slots[rowSlots[later]].row++;
+        }
+    }
+    summarize(event);
+    return EventId(slot, slots[slot].generation);
+}
+
+std::vector<EventId> Calendar::addEvents(const std::vector<Event>& batch) {
+    std::vector<EventId> ids;
+    ids.reserve(batch.size());
+    if (sortingDeferred) {
+        for (const Event& event : batch) {
+            ids.push_back(addEvent(event));
+        }
+        return ids;
+    }
+
+    std::vector<Event> sorted(batch);
+    std::vector<std::uint32_t> batchSlots(batch.size());
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        batchSlots[i] = allocateSlot(0);
+        ids.push_back(EventId(batchSlots[i], slots[batchSlots[i]].generation));
+    }
+    mergeBatch(sorted, batchSlots);
+    return ids;
+}
+
+std::vector<EventId> Calendar::addSortedBatches(std::vector<std::vector<Event>>& batches) {
+    std::vector<Event> batch;
+    std::size_t total = 0;
+    for (const std::vector<Event>& part : batches) {
+        total += part.size();
+    }
+    batch.reserve(total);
+
+    // Cursors into the concatenated batch, one per part, merged with a heap.
+    // Ties go to the earlier part, so the order is as if the parts had been
+    // appended one after another and sorted stably.
+    struct Cursor {
+        std::uint32_t next;
+        std::uint32_t end;
+        std::uint32_t part;
+    };
+    std::vector<Cursor> heap;
+    for (std::size_t part = 0; part < batches.size(); part++) {
+        const std::uint32_t first = static_cast<std::uint32_t>(batch.size());
+        std::move(batches[part].begin(), batches[part].end(), std::back_inserter(batch));
+        if (batch.size() > first) {
+            heap.push_back(Cursor{ first, static_cast<std::uint32_t>(batch.size()), static_cast<std::uint32_t>(part) });
+        }
+    }
+    batches.clear();
+
+    std::vector<EventId> ids;
+    ids.reserve(batch.size());
+    if (sortingDeferred) {
+        for (const Event& event : batch) {
+            ids.push_back(addEvent(event));
+        }
+        return ids;
+    }
+
+    auto later = [&](const Cursor& a, const Cursor& b) {
+        return batch[b.next] < batch[a.next] || (!(batch[a.next] < batch[b.next]) && b.part < a.part);
+    };
+    std::make_heap(heap.begin(), heap.end(), later);
+    std::vector<std::uint32_t> order;
+    order.reserve(batch.size());
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Cursor& cursor = heap.back();
+        order.push_back(cursor.next++);
+        if (cursor.next == cursor.end) {
+            heap.pop_back();
+        }
+        else {
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+
+    std::vector<std::uint32_t> batchSlots(batch.size());
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        batchSlots[i] = allocateSlot(0);
+        ids.push_back(EventId(batchSlots[i], slots[batchSlots[i]].generation));
+    }
+    mergeInOrder(batch, batchSlots, order);
+    return ids;
+}
+
+// Sorts batch, whose events own batchSlots, and merges both into the sorted
+// storage.
+void Calendar::mergeBatch(std::vector<Event>& batch, std::vector<std::uint32_t>& batchSlots) {
+    std::vector<std::uint32_t> order(batch.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<std::uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&](std::uint32_t a, std::uint32_t b) { return batch[a] < batch[b]; });
+    mergeInOrder(batch, batchSlots, order);
+}
+
+// Merges batch, taken in the sorted order given, into the sorted storage with
+// one linear pass. Tombstones are dropped on the way, since every row is
+// rewritten anyway.
+void Calendar::mergeInOrder(std::vector<Event>& batch, std::vector<std::uint32_t>& batchSlots,
+    const std::vector<std::uint32_t>& order) {
+    std::vector<Event> merged;
+    std::vector<std::uint32_t> mergedSlots;
+    merged.reserve(events.size() - columns.deadCount() + batch.size());
+    mergedSlots.reserve(merged.capacity());
+
+    // Existing events come first among equal keys, as with addEvent.
+    std::size_t row = 0;
+    auto takeExisting = [&] {
+        if (!columns.isDead(row)) {
+            merged.push_back(std::move(events[row]));
+            mergedSlots.push_back(rowSlots[row]);
+        }
+        row++;
+    };
+    for (std::uint32_t next : order) {
+        while (row < events.size() && !(batch[next] < events[row])) {
+            takeExisting();
+        }
+        merged.push_back(std::move(batch[next]));
+        mergedSlots.push_back(batchSlots[next]);
+        summarize(merged.back());
+    }
+    while (row < events.size()) {
+        takeExisting();
+    }
+
+    events.swap(merged);
+    rowSlots.swap(mergedSlots);
+    for (std::size_t i = 0; i < rowSlots.size(); i++) {
+        slots[rowSlots[i]].row = static_cast<std::uint32_t>(i);
+    }
+    rebuildColumns();
+}
+
+void Calendar::rebuildColumns() {
+    columns.clear();
+    columns.reserve(events.size());
+    for (std::size_t row = 0; row < events.size(); row++) {
+        const Event& event = events[row];
+        columns.insert(row, event.getDateTime().getValue(), static_cast<std::uint8_t>(event.getType()),
+            static_cast<std::uint8_t>(event.getPriority()), event.getTitle());
+    }
+}
+
+void Calendar::removeRow(std::size_t row) {
+    unsummarize(events[row]);
+    columns.kill(row);
+    releaseSlot(rowSlots[row]);
+    rowSlots[row] = FREE;
+
+    const std::size_t dead = columns.deadCount();
+    if (dead >= COMPACT_MIN_DEAD && dead * COMPACT_DEAD_DIVISOR >= events.size()) {
+        compact();
+    }
+}
+
+void Calendar::removeSeries(std::size_t index) {
+    releaseSlot(recurringSlots[index]);
+    recurring.erase(recurring.begin() + index);
+    recurringSlots.erase(recurringSlots.begin() + index);
+    for (std::size_t later = index; later < recurringSlots.size(); later++) {
+        slots[recurringSlots[later]].row--;
+    }
+}
+
+void Calendar::removePending(std::size_t index) {
+    releaseSlot(pendingSlots[index]);
+    pendingEvents.erase(pendingEvents.begin() + index);
+    pendingSlots.erase(pendingSlots.begin() + index);
+    for (std::size_t later = index; later < pendingSlots.size(); later++) {
+        slots[pendingSlots[later]].row--;
+    }
+}
+
+bool Calendar::removeEvent(EventId id) {
+    const std::uint32_t slot = resolve(id);
+    if (slot == FREE) {
+        return false;
+    }
+    const std::uint32_t row = slots[slot].row;
+    if ((row & PENDING) != 0) {
+        removePending(row & ~PENDING);
+    }
+    else if ((row & RECURRING) != 0) {
+        removeSeries(row & ~RECURRING);
+    }
+    else {
+        removeRow(row);
+    }
+    return true;
 }
 
 bool Calendar::removeEvent(const Event& event) {
-    auto it = std::find(events.begin(), events.end(), event);
-    if (it != events.end()) {
-        events.erase(it);
+    const auto& keys = columns.getKeys();
+    const std::int64_t key = event.getDateTime().getValue();
+    for (std::size_t row = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        row < keys.size() && keys[row] == key; row++) {
+        if (!columns.isDead(row) && events[row] == event) {
+            removeRow(row);
+            return true;
+        }
+    }
+    auto pending = std::find(pendingEvents.begin(), pendingEvents.end(), event);
+    if (pending != pendingEvents.end()) {
+        removePending(pending - pendingEvents.begin());
+        return true;
+    }
+    auto series = std::find_if(recurring.begin(), recurring.end(),
+        [&](const RecurringEvent& candidate) { return candidate.event == event; });
+    if (series != recurring.end()) {
+        removeSeries(series - recurring.begin());
         return true;
     }
     return false;
 }
 
+bool Calendar::updateEvent(EventId id, const Event& event) {
+    const std::uint32_t slot = resolve(id);
+    if (slot == FREE) {
+        return false;
+    }
+    const std::uint32_t row = slots[slot].row;
+    if ((row & PENDING) != 0) {
+        pendingEvents[row & ~PENDING] = event;
+        return true;
+    }
+    if ((row & RECURRING) != 0) {
+        recurring[row & ~RECURRING].event = event;
+        return true;
+    }
+
+    unsummarize(events[row]);
+    summarize(event);
+    const std::int64_t key = event.getDateTime().getValue();
+    if (key == columns.getKeys()[row]) {
+        events[row] = event;
+        columns.update(row, static_cast<std::uint8_t>(event.getType()),
+            static_cast<std::uint8_t>(event.getPriority()), event.getTitle());
+        return true;
+    }
+
+    // The new position as addEvent would pick it, counted without this row.
+    const auto& keys = columns.getKeys();
+    std::size_t target = std::upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+    if (target > row) {
+        target--;
+    }
+
+    // Rotate only the rows between the old and the new position.
+    if (target > row) {
+        std::rotate(events.begin() + row, events.begin() + row + 1, events.begin() + target + 1);
+        std::rotate(rowSlots.begin() + row, rowSlots.begin() + row + 1, rowSlots.begin() + target + 1);
+    }
+    else {
+        std::rotate(events.begin() + target, events.begin() + row, events.begin() + row + 1);
+        std::rotate(rowSlots.begin() + target, rowSlots.begin() + row, rowSlots.begin() + row + 1);
+    }
+    for (std::size_t moved = std::min<std::size_t>(row, target); moved <= std::max<std::size_t>(row, target); moved++) {
+        if (rowSlots[moved] != FREE) {
+            slots[rowSlots[moved]].row = static_cast<std::uint32_t>(moved);
+        }
+    }
+    events[target] = event;
+    columns.erase(row);
+    columns.insert(target, key, static_cast<std::uint8_t>(event.getType()),
+        static_cast<std::uint8_t>(event.getPriority()), event.getTitle());
+    return true;
+}
+
+const Event* Calendar::findEvent(EventId id) const {
+    const std::uint32_t slot = resolve(id);
+    if (slot == FREE) {
+        return nullptr;
+    }
+    const std::uint32_t row = slots[slot].row;
+    if ((row & PENDING) != 0) {
+        return &pendingEvents[row & ~PENDING];
+    }
+    return (row & RECURRING) != 0 ? &recurring[row & ~RECURRING].event : &events[row];
+}
+
+EventId Calendar::addRecurringEvent(const Event& first, const RecurrenceRule& rule) {
+    const std::uint32_t slot = allocateSlot(RECURRING | static_cast<std::uint32_t>(recurring.size()));
+    recurring.push_back(RecurringEvent{ first, rule });
+    recurringSlots.push_back(slot);
+    return EventId(slot, slots[slot].generation);
+}
+
+const RecurrenceRule* Calendar::findRecurrence(EventId id) const {
+    const std::uint32_t slot = resolve(id);
+    if (slot == FREE || (slots[slot].row & (PENDING | RECURRING)) != RECURRING) {
+        return nullptr;
+    }
+    return &recurring[slots[slot].row & ~RECURRING].rule;
+}
+
+bool Calendar::updateRecurrence(EventId id, const RecurrenceRule& rule) {
+    const std::uint32_t slot = resolve(id);
+    if (slot == FREE || (slots[slot].row & (PENDING | RECURRING)) != RECURRING) {
+        return false;
+    }
+    recurring[slots[slot].row & ~RECURRING].rule = rule;
+    return true;
+}
+
+std::shared_ptr<const std::vector<Event>> Calendar::expandOccurrences(const Date& from, const Date& to,
+    const EventFilter::Criteria& criteria) const {
+    return expandOccurrences(from, to, criteria.typeMask(), criteria.priorityMask());
+}
+
+std::shared_ptr<std::vector<Event>> Calendar::expandOccurrences(const Date& from, const Date& to, std::uint16_t typeMask,
+    std::uint16_t priorityMask) const {
+    if (recurring.empty()) {
+        return nullptr;
+    }
+    auto occurrences = std::make_shared<std::vector<Event>>();
+    for (const RecurringEvent& series : recurring) {
+        if ((typeMask >> static_cast<int>(series.event.getType()) & 1) == 0 ||
+            (priorityMask >> static_cast<int>(series.event.getPriority()) & 1) == 0) {
+            continue;
+        }
+        for (const Date& date : series.rule.occurrencesBetween(series.event.getDate(), from, to)) {
+            occurrences->push_back(series.event);
+            occurrences->back().setDate(date);
+        }
+    }
+    if (occurrences->empty()) {
+        return nullptr;
+    }
+    // Series are kept in the order they were added, which settles ties.
+    std::stable_sort(occurrences->begin(), occurrences->end());
+    return occurrences;
+}
+
+bool Calendar::summarizeOccurrences(DaySummaryCache& cache, const Date& from, const Date& to) const {
+    bool any = false;
+    for (const RecurringEvent& series : recurring) {
+        for (const Date& date : series.rule.occurrencesBetween(series.event.getDate(), from, to)) {
+            cache.add(date, static_cast<std::uint8_t>(series.event.getPriority()), series.event.getHasTime());
+            any = true;
+        }
+    }
+    return any;
+}
+
+void Calendar::compact() {
+    if (columns.deadCount() == 0) {
+        return;
+    }
+    std::size_t kept = 0;
+    for (std::size_t row = 0; row < events.size(); row++) {
+        if (columns.isDead(row)) {
+            continue;
+        }
+        if (kept != row) {
+            events[kept] = std::move(events[row]);
+            rowSlots[kept] = rowSlots[row];
+        }
+        slots[rowSlots[kept]].row = static_cast<std::uint32_t>(kept);
+        kept++;
+    }
+    events.erase(events.begin() + kept, events.end());
+    rowSlots.resize(kept);
+    rebuildColumns();
+}
+
 void Calendar::clearEvents() {
+    for (std::uint32_t slot : rowSlots) {
+        if (slot != FREE) {
+            releaseSlot(slot);
+        }
+    }
+    for (std::uint32_t slot : pendingSlots) {
+        releaseSlot(slot);
+    }
+    for (std::uint32_t slot : recurringSlots) {
+        releaseSlot(slot);
+    }
+    recurring.clear();
+    recurringSlots.clear();
     events.clear();
+    rowSlots.clear();
+    columns.clear();
+    daySummaries.clear();
+    pendingEvents.clear();
+    pendingSlots.clear();
+}
+
+void Calendar::deferSorting() {
+    sortingDeferred = true;
+}
+
+void Calendar::commitEvents() {
+    sortingDeferred = false;
+    if (!pendingEvents.empty()) {
+        std::vector<Event> batch;
+        std::vector<std::uint32_t> batchSlots;
+        batch.swap(pendingEvents);
+        batchSlots.swap(pendingSlots);
+        mergeBatch(batch, batchSlots);
+    }
 }
 
 void Calendar::nextMonth() {
@@ -158,95 +617,113 @@ void Calendar::goToToday() {
     currentViewDate = Date();
 }
 
-void Calendar::displayMonthHeader(int month, int year) const {
-    static const std::string monthNames[] = {
-        "", "January", "February", "March", "April", "May", "June",
-        "July", "August", "September", "October", "November", "December"
-    };
+static const char* const MONTH_NAMES[] = {
+    "", "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December"
+};
 
-    std::cout << "\n";
-    std::cout << std::string(10, ' ') << monthNames[month] << " " << year << std::endl;
-    std::cout << "Su Mo Tu We Th Fr Sa" << std::endl;
-}
-
-void Calendar::displayMonthCalendar(int month, int year) const {
-    displayMonthHeader(month, year);
+// Width of one month in the year grid: seven "DD " cells.
+static constexpr std::size_t GRID_MONTH_WIDTH = 21;
+static constexpr std::size_t GRID_GAP = 3;
 
-    Date firstDay(1, month, year);
-    int startingDay = firstDay.getDayOfWeekNumber();
+void Calendar::renderMonthHeader(RenderBuffer& out, int month, int year) const {
+    out << '\n';
+    out.append(10, ' ') << MONTH_NAMES[month] << ' ';
+    out.appendNumber(year) << '\n';
+    out << "Su Mo Tu We Th Fr Sa\n";
+}
 
-    Date today;
+// The Sunday on or before the first of the month, where its grid starts.
+static Date gridStart(int month, int year) {
+    const Date firstDay(1, month, year);
+    return firstDay - firstDay.getDayOfWeekNumber();
+}
 
-    int daysInMonth = firstDay.getDaysInMonth(month, year);
+// Writes the grid row of the week starting on weekStart without a line break.
+// With pad the row is always seven cells wide; otherwise it stops after the
+// last day of the month.
+void Calendar::renderWeekRow(RenderBuffer& out, int month, int year, const Date& weekStart, const Date& today, bool pad,
+    const DaySummaryCache* occurrences) const {
+    const Date firstDay(1, month, year);
+    const Date lastDay = firstDay.addMonths(1) - 1;
 
-    for (int i = 0; i < startingDay; i++) {
-        std::cout << "   ";
-    }
+    for (const Date currentDate : DateRange(weekStart, weekStart + 7)) {
+        if (currentDate < firstDay || currentDate > lastDay) {
+            if (currentDate > lastDay && !pad) {
+                return;
+            }
+            out << "   ";
+            continue;
+        }
 
-    for (int day = 1; day <= daysInMonth; day++) {
-        Date currentDate(day, month, year);
         bool isToday = (currentDate == today);
-        bool hasEvent = hasEvents(currentDate);
-        bool isImportant = hasImportantEvents(currentDate);
+        DaySummary summary = daySummaries.get(currentDate);
+        if (occurrences != nullptr) {
+            summary.merge(occurrences->get(currentDate));
+        }
+        bool hasEvent = summary.hasEvents();
+        bool isImportant = summary.maxPriority() >= static_cast<int>(EventPriority::MEDIUM);
 
         if (isToday) {
-            std::cout << "\033[1;32m";
+            out.beginColor(RenderBuffer::Color::Green);
         }
         else if (isImportant) {
-            std::cout << "\033[1;31m";
+            out.beginColor(RenderBuffer::Color::Red);
         }
         else if (hasEvent) {
-            std::cout << "\033[1;34m";
+            out.beginColor(RenderBuffer::Color::Blue);
         }
 
-        std::cout << std::setw(2) << day;
+        out.appendTwoDigits(currentDate.getDay());
 
         if (isToday || hasEvent || isImportant) {
-            std::cout << "\033[0m";
+            out.endColor();
         }
 
-        std::cout << " ";
-
-        if ((startingDay + day) % 7 == 0) {
-            std::cout << std::endl;
-        }
+        out << ' ';
     }
+}
+
+void Calendar::renderMonthCalendar(RenderBuffer& out, int month, int year, const Date& today) const {
+    renderMonthHeader(out, month, year);
 
-    if ((startingDay + daysInMonth) % 7 != 0) {
-        std::cout << std::endl;
+    const Date firstDay(1, month, year);
+    const Date nextMonth = firstDay.addMonths(1);
+    DaySummaryCache occurrences;
+    const bool recurs = summarizeOccurrences(occurrences, firstDay, nextMonth - 1);
+
+    // One row per week that has a day of the month.
+    for (const Date weekStart : DateRange(gridStart(month, year), nextMonth, DateRange::Step::Week)) {
+        renderWeekRow(out, month, year, weekStart, today, false, recurs ? &occurrences : nullptr);
+        out << '\n';
     }
 
-    std::cout << std::endl;
+    out << '\n';
+}
+
+std::vector<Event>::const_iterator Calendar::firstEventFrom(const Date& date) const {
+    // The packed keys are contiguous, so the search never loads an Event.
+    const auto& keys = columns.getKeys();
+    return events.begin() + (std::lower_bound(keys.begin(), keys.end(), DateTime(date).getValue()) - keys.begin());
 }
 
 bool Calendar::hasEvents(const Date& date) const {
-    for (const Event& event : events) {
-        if (event.getDate() == date) {
-            return true;
-        }
-    }
-    return false;
+    return getDaySummary(date).hasEvents();
 }
 
 bool Calendar::hasImportantEvents(const Date& date) const {
-    for (const Event& event : events) {
-        if (event.getDate() == date &&
-            (event.getPriority() == EventPriority::HIGH ||
-                event.getPriority() == EventPriority::MEDIUM)) {
-            return true;
-        }
-    }
-    return false;
+    return getDaySummary(date).maxPriority() >= static_cast<int>(EventPriority::MEDIUM);
 }
 
-std::vector<Event> Calendar::getEventsOnDate(const Date& date) const {
-    std::vector<Event> result;
-    for (const Event& event : events) {
-        if (event.getDate() == date) {
-            result.push_back(event);
+DaySummary Calendar::getDaySummary(const Date& date) const {
+    DaySummary summary = daySummaries.get(date);
+    if (!recurring.empty()) {
+        DaySummaryCache occurrences;
+        if (summarizeOccurrences(occurrences, date, date)) {
+            summary.merge(occurrences.get(date));
         }
     }
-    return result;
+    return summary;
 }
 
 void Calendar::displayCurrentMonth() const {
@@ -254,83 +731,264 @@ void Calendar::displayCurrentMonth() const {
 }
 
 void Calendar::displayMonth(int month, int year) const {
-    displayMonthCalendar(month, year);
+    RenderBuffer out;
+    renderMonth(out, month, year);
+    out.writeTo(std::cout);
+}
+
+void Calendar::displayMonth(int month, int year, const TimeZone& zone) const {
+    RenderBuffer out;
+    renderMonth(out, month, year, zone);
+    out.writeTo(std::cout);
+}
+
+void Calendar::displayYear(int year, YearLayout layout) const {
+    RenderBuffer out;
+    renderYear(out, year, layout);
+    out.writeTo(std::cout);
+}
 
-    std::vector<Event> monthEvents = getEventsByMonth(month, year);
+void Calendar::renderMonth(RenderBuffer& out, int month, int year) const {
+    renderMonthCalendar(out, month, year, Date());
+
+    EventFilter monthEvents = getEventsByMonth(month, year);
     if (!monthEvents.empty()) {
-        std::cout << "Events this month:" << std::endl;
-        displayEvents(monthEvents);
+        out << "Events this month:\n";
+        renderEvents(out, monthEvents);
     }
 }
 
-void Calendar::displayYear(int year) const {
-    std::cout << "\n\n" << std::string(20, '-') << " Calendar for " << year << " " << std::string(20, '-') << "\n\n";
+void Calendar::renderMonth(RenderBuffer& out, int month, int year, const TimeZone& zone) const {
+    const TimeZone& localZone = TimeZone::local();
+    const Date firstDay(1, month, year);
+    const Date lastDay(firstDay.getDaysInMonth(month, year), month, year);
+
+    // UTC offsets differ by at most 26 hours, so only events stored within two
+    // days of the month can land in it after conversion.
+    Calendar zoned(firstDay);
+    for (const Event& event : getEventsByDateRange(firstDay - 2, lastDay + 2)) {
+        Event shifted(event);
+        if (event.getHasTime()) {
+            const DateTime when = TimeZone::convert(event.getDateTime(), localZone, zone);
+            shifted.setDate(when.getDate());
+            shifted.setTime(when.getTime());
+        }
+        if (shifted.getDate() >= firstDay && shifted.getDate() <= lastDay) {
+            zoned.events.push_back(shifted);
+            zoned.summarize(shifted);
+        }
+    }
+    std::sort(zoned.events.begin(), zoned.events.end());
+    zoned.rebuildColumns();
+
+    out << '\n';
+    out.append(10, ' ') << '(' << zone.getName() << ')';
+    zoned.renderMonthCalendar(out, month, year, zone.today());
 
-    for (int month = 1; month <= 12; month++) {
-        displayMonthCalendar(month, year);
-        std::cout << std::endl;
+    if (!zoned.events.empty()) {
+        out << "Events this month:\n";
+        renderEvents(out, std::span<const Event>(zoned.events));
     }
 }
 
-std::vector<Event> Calendar::getAllEvents() const {
-    return events;
+int Calendar::yearPartCount(YearLayout layout) {
+    return layout == YearLayout::Column ? 12 : 4;
+}
+
+void Calendar::renderYearHeader(RenderBuffer& out, int year) const {
+    out << "\n\n";
+    out.append(20, '-') << " Calendar for ";
+    out.appendNumber(year) << ' ';
+    out.append(20, '-') << "\n\n";
 }
 
-std::vector<Event> Calendar::getEventsByType(EventType type) const {
-    std::vector<Event> result;
-    for (const Event& event : events) {
-        if (event.getType() == type) {
-            result.push_back(event);
+void Calendar::renderYearPart(RenderBuffer& out, int year, int part, YearLayout layout, const Date& today) const {
+    if (layout == YearLayout::Column) {
+        renderMonthCalendar(out, part + 1, year, today);
+        out << '\n';
+        return;
+    }
+
+    // Three months side by side. Every row of a month is padded to the same
+    // visible width, so the colour codes do not skew the columns.
+    const int first = part * 3 + 1;
+    for (int month = first; month < first + 3; month++) {
+        const std::string_view name = MONTH_NAMES[month];
+        const std::size_t titleWidth = name.size() + 5;  // " YYYY"
+        const std::size_t left = (GRID_MONTH_WIDTH - titleWidth) / 2;
+        out.append(left, ' ') << name << ' ';
+        out.appendNumber(year);
+        if (month < first + 2) {
+            out.append(GRID_MONTH_WIDTH - left - titleWidth + GRID_GAP, ' ');
         }
     }
-    return result;
+    out << '\n';
+    for (int month = first; month < first + 3; month++) {
+        out << "Su Mo Tu We Th Fr Sa";
+        out.append(month < first + 2 ? GRID_GAP + 1 : 0, ' ');
+    }
+    out << '\n';
+
+    DaySummaryCache occurrences;
+    const bool recurs = summarizeOccurrences(occurrences, Date(1, first, year), Date(1, first, year).addMonths(3) - 1);
+    const DateRange weeks[3] = {
+        DateRange(gridStart(first, year), gridStart(first, year) + 42, DateRange::Step::Week),
+        DateRange(gridStart(first + 1, year), gridStart(first + 1, year) + 42, DateRange::Step::Week),
+        DateRange(gridStart(first + 2, year), gridStart(first + 2, year) + 42, DateRange::Step::Week)
+    };
+    for (int week = 0; week < 6; week++) {
+        for (int month = first; month < first + 3; month++) {
+            renderWeekRow(out, month, year, weeks[month - first][week], today, true, recurs ? &occurrences : nullptr);
+            if (month < first + 2) {
+                out.append(GRID_GAP, ' ');
+            }
+        }
+        out << '\n';
+    }
+    out << '\n';
 }
 
-std::vector<Event> Calendar::getEventsByPriority(EventPriority priority) const {
-    std::vector<Event> result;
-    for (const Event& event : events) {
-        if (event.getPriority() == priority) {
-            result.push_back(event);
-        }
+void Calendar::renderYear(RenderBuffer& out, int year, YearLayout layout) const {
+    renderYearHeader(out, year);
+
+    const Date today;
+    const int parts = yearPartCount(layout);
+    for (int part = 0; part < parts; part++) {
+        renderYearPart(out, year, part, layout, today);
     }
-    return result;
 }
 
-std::vector<Event> Calendar::getEventsByDateRange(const Date& startDate, const Date& endDate) const {
-    std::vector<Event> result;
-    for (const Event& event : events) {
-        if (event.getDate() >= startDate && event.getDate() <= endDate) {
-            result.push_back(event);
-        }
+EventFilter Calendar::getAllEvents() const {
+    return EventFilter(events.data(), columns, 0, events.size(), EventFilter::Criteria());
+}
+
+EventFilter Calendar::getEventsByType(EventType type) const {
+    EventFilter::Criteria criteria;
+    criteria.type = type;
+    return EventFilter(events.data(), columns, 0, events.size(), criteria);
+}
+
+EventFilter Calendar::getEventsByPriority(EventPriority priority) const {
+    EventFilter::Criteria criteria;
+    criteria.priority = priority;
+    return EventFilter(events.data(), columns, 0, events.size(), criteria);
+}
+
+EventFilter Calendar::getEventsByType(EventType type, const Date& startDate, const Date& endDate) const {
+    EventFilter::Criteria criteria;
+    criteria.type = type;
+    return filterRange(startDate, endDate, criteria);
+}
+
+EventFilter Calendar::getEventsByPriority(EventPriority priority, const Date& startDate, const Date& endDate) const {
+    EventFilter::Criteria criteria;
+    criteria.priority = priority;
+    return filterRange(startDate, endDate, criteria);
+}
+
+EventFilter Calendar::filterRange(const Date& startDate, const Date& endDate, const EventFilter::Criteria& criteria) const {
+    if (endDate < startDate) {
+        return EventFilter();
     }
-    return result;
+    return EventFilter(events.data(), columns, firstEventFrom(startDate) - events.begin(),
+        firstEventFrom(endDate + 1) - events.begin(), criteria, expandOccurrences(startDate, endDate, criteria));
 }
 
-std::vector<Event> Calendar::getEventsByMonth(int month, int year) const {
-    std::vector<Event> result;
-    for (const Event& event : events) {
-        if (event.getDate().getMonth() == month && event.getDate().getYear() == year) {
-            result.push_back(event);
-        }
+EventFilter Calendar::getEventsByDateRange(const Date& startDate, const Date& endDate) const {
+    return filterRange(startDate, endDate, EventFilter::Criteria());
+}
+
+EventFilter Calendar::getEventsByMonth(int month, int year) const {
+    if (!Date::isValidDate(1, month, year)) {
+        return EventFilter();
     }
-    return result;
+    const Date firstDay(1, month, year);
+    return filterRange(firstDay, firstDay.addMonths(1) - 1, EventFilter::Criteria());
+}
+
+EventQuery Calendar::query() const {
+    return EventQuery(*this);
 }
 
-Date Calendar::calculateSemesterEndDate(const Date& startDate, int weeks) {
-    return startDate + (weeks * 7);
+// Heap bytes behind a string; short strings live inside the object.
+static std::size_t heapBytes(const std::string& text) {
+    static const std::size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
+static std::size_t eventBytes(const Event& event) {
+    return heapBytes(event.getTitle()) + heapBytes(event.getDescription());
+}
+
+static std::size_t eventBytes(const std::vector<Event>& list) {
+    std::size_t bytes = list.capacity() * sizeof(Event);
+    for (const Event& event : list) {
+        bytes += eventBytes(event);
+    }
+    return bytes;
+}
+
+std::size_t Calendar::memoryUsage() const {
+    std::size_t seriesBytes = recurring.capacity() * sizeof(RecurringEvent) +
+        recurringSlots.capacity() * sizeof(std::uint32_t);
+    for (const RecurringEvent& series : recurring) {
+        seriesBytes += eventBytes(series.event) + series.rule.getExceptions().capacity() * sizeof(Date);
+    }
+    return sizeof(*this) + eventBytes(events) + eventBytes(pendingEvents) + columns.memoryUsage() +
+        daySummaries.memoryUsage() +
+        (rowSlots.capacity() + pendingSlots.capacity() + freeSlots.capacity()) * sizeof(std::uint32_t) +
+        slots.capacity() * sizeof(Slot) + seriesBytes;
 }
 
-void Calendar::displayEvents(const std::vector<Event>& eventList) const {
-    if (eventList.empty()) {
-        std::cout << "No events found." << std::endl;
+Date Calendar::calculateSemesterEndDate(const Date& startDate, int weeks, const BusinessCalendar& workingDays) {
+    return workingDays.addBusinessDays(startDate, weeks * workingDays.getWorkingDaysPerWeek());
+}
+
+template <typename EventRange>
+static void renderEventList(RenderBuffer& out, const EventRange& eventList) {
+    if (std::ranges::empty(eventList)) {
+        out << "No events found.\n";
         return;
     }
 
-    for (size_t i = 0; i < eventList.size(); i++) {
-        std::cout << (i + 1) << ". " << eventList[i] << std::endl;
+    long long i = 0;
+    for (const Event& event : eventList) {
+        out.appendNumber(++i) << ". ";
+        event.renderTo(out);
+        out << '\n';
     }
 }
 
+void Calendar::renderEvents(RenderBuffer& out, std::span<const Event> eventList) const {
+    renderEventList(out, eventList);
+}
+
+void Calendar::renderEvents(RenderBuffer& out, const EventFilter& eventList) const {
+    renderEventList(out, eventList);
+}
+
+void Calendar::renderEvents(RenderBuffer& out, const EventSelection& eventList) const {
+    renderEventList(out, eventList);
+}
+
+void Calendar::displayEvents(std::span<const Event> eventList) const {
+    RenderBuffer out;
+    renderEvents(out, eventList);
+    out.writeTo(std::cout);
+}
+
+void Calendar::displayEvents(const EventFilter& eventList) const {
+    RenderBuffer out;
+    renderEvents(out, eventList);
+    out.writeTo(std::cout);
+}
+
+void Calendar::displayEvents(const EventSelection& eventList) const {
+    RenderBuffer out;
+    renderEvents(out, eventList);
+    out.writeTo(std::cout);
+}
+
 void Calendar::displayBirthdayInfo(const Date& birthDate) {
     std::cout << "Birthday: " << birthDate << std::endl;
     std::cout << "Day of the week: " << birthDate.getDayOfWeek() << std::endl;
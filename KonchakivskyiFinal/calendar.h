@@ -2,9 +2,24 @@
 #define CALENDAR_H
 
 #include "datetime.h"
+#include "timezone.h"
+#include "eventcolumns.h"
+#include "daysummary.h"
+#include "renderbuffer.h"
+#include "recurrence.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+
+class BusinessCalendar;
+class EventQuery;
+class EventSelection;
 
 enum class EventType {
     MEETING,
@@ -21,9 +36,7 @@ enum class EventPriority {
 
 class Event {
 private:
-    Date date;
-    Time time;
-    bool hasTime;
+    DateTime when;
     EventType type;
     EventPriority priority;
     std::string title;
@@ -40,21 +53,22 @@ public:
         EventPriority priority = EventPriority::MEDIUM,
         const std::string& description = "");
 
-    Date getDate() const { return date; }
-    Time getTime() const { return time; }
-    bool getHasTime() const { return hasTime; }
+    Date getDate() const { return when.getDate(); }
+    Time getTime() const { return when.getTime(); }
+    bool getHasTime() const { return when.hasTime(); }
+    const DateTime& getDateTime() const { return when; }
     EventType getType() const { return type; }
     EventPriority getPriority() const { return priority; }
-    std::string getTitle() const { return title; }
-    std::string getDescription() const { return description; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getDescription() const { return description; }
 
-    void setDate(const Date& date) { this->date = date; }
-    void setTime(const Time& time) { this->time = time; this->hasTime = true; }
+    void setDate(const Date& date) { when = when.withDate(date); }
+    void setTime(const Time& time) { when = DateTime(when.getDate(), time); }
     void setType(EventType type) { this->type = type; }
     void setPriority(EventPriority priority) { this->priority = priority; }
     void setTitle(const std::string& title) { this->title = title; }
     void setDescription(const std::string& description) { this->description = description; }
-    void removeTime() { hasTime = false; }
+    void removeTime() { when = when.withoutTime(); }
 
     bool operator<(const Event& other) const;
     bool operator>(const Event& other) const;
@@ -63,31 +77,272 @@ public:
 
     void display() const;
     std::string toString() const;
+    // Appends what operator<< writes.
+    void renderTo(RenderBuffer& out) const;
     friend std::ostream& operator<<(std::ostream& os, const Event& event);
 
     static std::string eventTypeToString(EventType type);
     static std::string eventPriorityToString(EventPriority priority);
 };
 
+// A lazy view of the events in a slice of a calendar that have the given type
+// and/or priority. Stored events are not copied: the view refers to the
+// calendar's storage and is invalidated when events change. Matches are found
+// by scanning the calendar's EventColumns, so skipped events are never loaded.
+//
+// Occurrences of recurring events in the slice are the exception. The query
+// generates them as Event copies in a shared heap vector that the view (and
+// its copies) owns, and the iterators merge them in by date and time. They
+// point into that vector, so unlike the calendar's spans the view is not a
+// borrowed range: an iterator must not outlive every copy of its view.
+class EventFilter : public std::ranges::view_interface<EventFilter> {
+public:
+    struct Criteria {
+        std::optional<EventType> type;
+        std::optional<EventPriority> priority;
+
+        bool matches(const Event& event) const {
+            return (!type || event.getType() == *type) &&
+                (!priority || event.getPriority() == *priority);
+        }
+        // unconstrained is what to accept without a type, e.g. liveTypes().
+        std::uint16_t typeMask(std::uint16_t unconstrained = EventColumns::ANY) const {
+            return type ? static_cast<std::uint16_t>(1u << static_cast<int>(*type)) : unconstrained;
+        }
+        std::uint16_t priorityMask() const {
+            return priority ? static_cast<std::uint16_t>(1u << static_cast<int>(*priority)) : EventColumns::ANY;
+        }
+    };
+
+    class iterator {
+    private:
+        const Event* events = nullptr;          // row 0 of the columns
+        const EventColumns* columns = nullptr;
+        std::size_t row = 0;
+        std::size_t last = 0;
+        std::uint16_t typeMask = EventColumns::ANY;
+        std::uint16_t priorityMask = EventColumns::ANY;
+        const Event* extra = nullptr;           // next occurrence
+        const Event* extraEnd = nullptr;
+
+        // Stored events come first among equal dates and times.
+        bool onExtra() const { return extra != extraEnd && (row == last || *extra < events[row]); }
+
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Event;
+        using difference_type = std::ptrdiff_t;
+        using reference = const Event&;
+        using pointer = const Event*;
+
+        iterator() = default;
+        iterator(const Event* events, const EventColumns* columns, std::size_t row, std::size_t last,
+            std::uint16_t typeMask, std::uint16_t priorityMask, const Event* extra, const Event* extraEnd)
+            : events(events), columns(columns), row(row), last(last), typeMask(typeMask), priorityMask(priorityMask),
+            extra(extra), extraEnd(extraEnd) {
+            if (row != last) {
+                this->row = columns->findNext(row, last, typeMask, priorityMask);
+            }
+        }
+
+        const Event& operator*() const { return onExtra() ? *extra : events[row]; }
+        const Event* operator->() const { return onExtra() ? extra : events + row; }
+        iterator& operator++() {
+            if (onExtra()) {
+                ++extra;
+            }
+            else {
+                row = columns->findNext(row + 1, last, typeMask, priorityMask);
+            }
+            return *this;
+        }
+        iterator operator++(int) { iterator temp(*this); ++*this; return temp; }
+        bool operator==(const iterator& other) const { return row == other.row && extra == other.extra; }
+    };
+
+private:
+    const Event* events = nullptr;
+    const EventColumns* columns = nullptr;
+    std::size_t first = 0;
+    std::size_t last = 0;
+    Criteria criteria;
+    std::shared_ptr<const std::vector<Event>> occurrences;
+
+public:
+    EventFilter() = default;
+    // events and columns describe the same rows; the view covers [first, last).
+    // occurrences, if any, are sorted and already match the criteria.
+    EventFilter(const Event* events, const EventColumns& columns, std::size_t first, std::size_t last,
+        const Criteria& criteria, std::shared_ptr<const std::vector<Event>> occurrences = nullptr)
+        : events(events), columns(&columns), first(first), last(last), criteria(criteria),
+        occurrences(std::move(occurrences)) {}
+
+    // Tombstoned rows are skipped along with the mismatches.
+    iterator begin() const {
+        return iterator(events, columns, first, last, typeMask(), criteria.priorityMask(),
+            extraBegin(), extraEnd());
+    }
+    iterator end() const {
+        return iterator(events, columns, last, last, typeMask(), criteria.priorityMask(),
+            extraEnd(), extraEnd());
+    }
+    bool empty() const { return begin() == end(); }
+    // A popcount over the type and priority bitmaps; no Event is read.
+    std::size_t count() const {
+        return (columns == nullptr ? 0 : columns->count(first, last, typeMask(), criteria.priorityMask())) +
+            (occurrences ? occurrences->size() : 0);
+    }
+
+private:
+    std::uint16_t typeMask() const {
+        return criteria.typeMask(columns == nullptr ? EventColumns::ANY : columns->liveTypes());
+    }
+    const Event* extraBegin() const { return occurrences ? occurrences->data() : nullptr; }
+    const Event* extraEnd() const { return occurrences ? occurrences->data() + occurrences->size() : nullptr; }
+};
+
+// A stable handle to an event in a Calendar. It stays valid while the event
+// moves within the calendar's ordering and goes stale once the event is
+// removed; a stale handle never refers to a later event.
+class EventId {
+private:
+    friend class Calendar;
+
+    std::uint32_t slot = UINT32_MAX;
+    std::uint32_t generation = 0;
+
+    EventId(std::uint32_t slot, std::uint32_t generation) : slot(slot), generation(generation) {}
+
+public:
+    EventId() = default;
+
+    bool isNull() const { return slot == UINT32_MAX; }
+    bool operator==(const EventId& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const EventId& other) const { return !(*this == other); }
+};
+
 class Calendar {
+public:
+    // A repeating event: its first occurrence and the rule for the rest.
+    struct RecurringEvent {
+        Event event;
+        RecurrenceRule rule;
+    };
+
 private:
+    friend class EventQuery;
+
+    // Slot map behind EventId. A slot holds the row of its event in events,
+    // or PENDING | index into pendingEvents, or RECURRING | index into
+    // recurring, or FREE.
+    struct Slot {
+        std::uint32_t row;
+        std::uint32_t generation;
+    };
+    static constexpr std::uint32_t FREE = UINT32_MAX;
+    static constexpr std::uint32_t PENDING = std::uint32_t(1) << 31;
+    static constexpr std::uint32_t RECURRING = std::uint32_t(1) << 30;
+
     std::vector<Event> events;
+    EventColumns columns;              // row i mirrors events[i]
+    std::vector<std::uint32_t> rowSlots;  // slot of events[i]; FREE for tombstones
+    DaySummaryCache daySummaries;      // per day of events, not pendingEvents
+    std::vector<Event> pendingEvents;  // added while sorting is deferred
+    std::vector<std::uint32_t> pendingSlots;
+    std::vector<RecurringEvent> recurring;  // in the order they were added
+    std::vector<std::uint32_t> recurringSlots;
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+    bool sortingDeferred = false;
     Date currentViewDate;
 
-    void displayMonthHeader(int month, int year) const;
-    void displayMonthCalendar(int month, int year) const;
+    // events is kept sorted by date and time, so date lookups are binary
+    // searches; this returns the first event on or after date.
+    std::vector<Event>::const_iterator firstEventFrom(const Date& date) const;
+    void rebuildColumns();
+    void summarize(const Event& event);
+    void unsummarize(const Event& event);
+
+    std::uint32_t allocateSlot(std::uint32_t row);
+    void releaseSlot(std::uint32_t slot);
+    // The slot an id refers to, or FREE if the id is stale.
+    std::uint32_t resolve(const EventId& id) const;
+    void mergeBatch(std::vector<Event>& batch, std::vector<std::uint32_t>& batchSlots);
+    void mergeInOrder(std::vector<Event>& batch, std::vector<std::uint32_t>& batchSlots,
+        const std::vector<std::uint32_t>& order);
+    void removeRow(std::size_t row);
+    void removePending(std::size_t index);
+    void removeSeries(std::size_t index);
+    // Every occurrence in [from, to] of the recurring events that match
+    // criteria, or whose type and priority are in the masks, sorted by date
+    // and time; nullptr if there are none.
+    std::shared_ptr<const std::vector<Event>> expandOccurrences(const Date& from, const Date& to,
+        const EventFilter::Criteria& criteria) const;
+    std::shared_ptr<std::vector<Event>> expandOccurrences(const Date& from, const Date& to, std::uint16_t typeMask,
+        std::uint16_t priorityMask) const;
+    // The stored events in [startDate, endDate] that match criteria, with the
+    // matching occurrences merged in.
+    EventFilter filterRange(const Date& startDate, const Date& endDate, const EventFilter::Criteria& criteria) const;
+    // Adds the occurrences in [from, to] to cache; false if there are none.
+    bool summarizeOccurrences(DaySummaryCache& cache, const Date& from, const Date& to) const;
+
+    void renderMonthHeader(RenderBuffer& out, int month, int year) const;
+    // occurrences holds the recurring events' days, or is nullptr.
+    void renderWeekRow(RenderBuffer& out, int month, int year, const Date& weekStart, const Date& today, bool pad,
+        const DaySummaryCache* occurrences) const;
+    void renderMonthCalendar(RenderBuffer& out, int month, int year, const Date& today) const;
     bool hasEvents(const Date& date) const;
     bool hasImportantEvents(const Date& date) const;
-    std::vector<Event> getEventsOnDate(const Date& date) const;
 
 public:
+    enum class YearLayout {
+        Column,     // one month under another
+        Grid        // three months across, four rows
+    };
+
     Calendar();
     Calendar(const Date& initialViewDate);
 
-    void addEvent(const Event& event);
+    EventId addEvent(const Event& event);
+    // Sorts the batch on its own and merges it in with one linear pass. The
+    // ids are in batch order.
+    std::vector<EventId> addEvents(const std::vector<Event>& batch);
+    // For loaders that sort on several threads: each batch must already be
+    // sorted by date and time. The batches are moved from and merged in
+    // with the stored events in one pass. Ids are in the order of the
+    // batches laid end to end.
+    std::vector<EventId> addSortedBatches(std::vector<std::vector<Event>>& batches);
+    // Removal leaves a tombstone that queries skip; the storage is compacted
+    // once tombstones make up a quarter of it.
+    bool removeEvent(EventId id);
     bool removeEvent(const Event& event);
+    // Replaces the event in place. If its date or time changed, only the
+    // events between its old and new positions move.
+    bool updateEvent(EventId id, const Event& event);
+    // nullptr for a stale id. For a recurring event this is its first
+    // occurrence.
+    const Event* findEvent(EventId id) const;
+
+    // Stores a repeating event as one event and its rule; occurrences are
+    // only generated for the dates a query or the month grid asks about.
+    // removeEvent, updateEvent and findEvent act on the whole series.
+    EventId addRecurringEvent(const Event& first, const RecurrenceRule& rule);
+    // nullptr unless id is a live recurring event.
+    const RecurrenceRule* findRecurrence(EventId id) const;
+    bool updateRecurrence(EventId id, const RecurrenceRule& rule);
+    // Every recurring event, for code that saves or exports a calendar: the
+    // unbounded queries below do not list them.
+    std::span<const RecurringEvent> getRecurringEvents() const { return recurring; }
+    // Drops all tombstones now. Ids stay valid.
+    void compact();
     void clearEvents();
 
+    // For loaders: events added after deferSorting() are only appended, and
+    // queries do not see them until commitEvents() merges them in one pass.
+    void deferSorting();
+    void commitEvents();
+
     void nextMonth();
     void previousMonth();
     void goToMonth(int month, int year);
@@ -95,17 +350,60 @@ public:
 
     void displayCurrentMonth() const;
     void displayMonth(int month, int year) const;
-    void displayYear(int year) const;
+    // Timed events are stored in local time; this shows them, and today's
+    // date, as seen from another zone.
+    void displayMonth(int month, int year, const TimeZone& zone) const;
+    void displayYear(int year, YearLayout layout = YearLayout::Column) const;
+
+    // The display functions render into a RenderBuffer and write it to
+    // std::cout once; these append the same text to a caller's buffer.
+    void renderMonth(RenderBuffer& out, int month, int year) const;
+    void renderMonth(RenderBuffer& out, int month, int year, const TimeZone& zone) const;
+    void renderYear(RenderBuffer& out, int year, YearLayout layout = YearLayout::Column) const;
+
+    // renderYear is the header followed by every part in order: a month in
+    // the column layout, a row of three months in the grid. Parts only read
+    // the calendar, so they can be rendered on several threads at once.
+    static int yearPartCount(YearLayout layout);
+    void renderYearHeader(RenderBuffer& out, int year) const;
+    void renderYearPart(RenderBuffer& out, int year, int part, YearLayout layout, const Date& today) const;
+
+    // Queries return views into the calendar's own sorted storage, valid
+    // until the next change to its events. Queries with a date window also
+    // list the occurrences of recurring events in it.
+    //
+    // The unbounded queries (and a query() with no end date) have no window
+    // to expand a series in, so they list single events only and leave out
+    // every recurring event; see getRecurringEvents().
+    EventFilter getAllEvents() const;
+    EventFilter getEventsByType(EventType type) const;
+    EventFilter getEventsByPriority(EventPriority priority) const;
+    EventFilter getEventsByType(EventType type, const Date& startDate, const Date& endDate) const;
+    EventFilter getEventsByPriority(EventPriority priority, const Date& startDate, const Date& endDate) const;
+    EventFilter getEventsByDateRange(const Date& startDate, const Date& endDate) const;
+    EventFilter getEventsByMonth(int month, int year) const;
+    // One hash probe; kept up to date as events are added and removed.
+    // Recurring events are checked for the date on top of that.
+    DaySummary getDaySummary(const Date& date) const;
+    // Combines any of the predicates above in one pass; see eventquery.h.
+    EventQuery query() const;
 
-    std::vector<Event> getAllEvents() const;
-    std::vector<Event> getEventsByType(EventType type) const;
-    std::vector<Event> getEventsByPriority(EventPriority priority) const;
-    std::vector<Event> getEventsByDateRange(const Date& startDate, const Date& endDate) const;
-    std::vector<Event> getEventsByMonth(int month, int year) const;
+    // Approximate bytes held by the events and every index over them, for
+    // comparing layouts (see CompactEventStore).
+    std::size_t memoryUsage() const;
 
-    static Date calculateSemesterEndDate(const Date& startDate, int weeks);
+    static constexpr Date calculateSemesterEndDate(const Date& startDate, int weeks) {
+        return startDate + (weeks * 7);
+    }
+    // Counts weeks of working days, so every holiday pushes the end date back.
+    static Date calculateSemesterEndDate(const Date& startDate, int weeks, const BusinessCalendar& workingDays);
 
-    void displayEvents(const std::vector<Event>& eventList) const;
+    void displayEvents(std::span<const Event> eventList) const;
+    void displayEvents(const EventFilter& eventList) const;
+    void displayEvents(const EventSelection& eventList) const;
+    void renderEvents(RenderBuffer& out, std::span<const Event> eventList) const;
+    void renderEvents(RenderBuffer& out, const EventFilter& eventList) const;
+    void renderEvents(RenderBuffer& out, const EventSelection& eventList) const;
 
     static void displayBirthdayInfo(const Date& birthDate);
 };
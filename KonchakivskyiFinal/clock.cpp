@@ -0,0 +1,66 @@
+#include "clock.h"
+
+std::atomic<std::uint64_t> WallClock::snapshot{ 0 };
+
+static constexpr std::int64_t SECONDS_PER_DAY = 24 * 3600;
+static constexpr std::uint64_t SECOND_MASK = (std::uint64_t(1) << 46) - 1;
+
+bool WallClock::toLocalTime(std::time_t utc, std::tm& result) {
+#ifdef _WIN32
+    return localtime_s(&result, &utc) == 0;
+#else
+    return localtime_r(&utc, &result) != nullptr;
+#endif
+}
+
+std::uint64_t WallClock::publish(std::time_t utc) {
+    std::int64_t offset = 0;
+    std::tm ltm;
+    if (toLocalTime(utc, ltm)) {
+        // Not the Date constructor: its fallback for years past MAX_YEAR
+        // would read this clock while it is being published.
+        const int localDay = Date::dayNumberOf(ltm.tm_mday, 1 + ltm.tm_mon, 1900 + ltm.tm_year);
+        const std::int64_t local = localDay * SECONDS_PER_DAY +
+            ltm.tm_hour * 3600 + ltm.tm_min * 60 + ltm.tm_sec;
+        offset = local - static_cast<std::int64_t>(utc);
+    }
+
+    const std::uint64_t packed = ((static_cast<std::uint64_t>(utc) & SECOND_MASK) << OFFSET_BITS) |
+        static_cast<std::uint64_t>(offset + OFFSET_BIAS);
+    snapshot.store(packed, std::memory_order_release);
+    return packed;
+}
+
+std::int64_t WallClock::localSeconds() {
+    const std::time_t utc = std::time(nullptr);
+    std::uint64_t packed = snapshot.load(std::memory_order_acquire);
+
+    if (packed == 0 || (packed >> OFFSET_BITS) != (static_cast<std::uint64_t>(utc) & SECOND_MASK)) {
+        packed = publish(utc);
+    }
+
+    const std::int64_t offset = static_cast<std::int64_t>(packed & ((std::uint64_t(1) << OFFSET_BITS) - 1)) - OFFSET_BIAS;
+    return static_cast<std::int64_t>(utc) + offset;
+}
+
+Date WallClock::today() {
+    const std::int64_t local = localSeconds();
+    std::int64_t days = local / SECONDS_PER_DAY;
+    if (local % SECONDS_PER_DAY < 0) {
+        days--;
+    }
+    return Date::fromDayNumber(static_cast<int>(days));
+}
+
+Time WallClock::now() {
+    std::int64_t secondOfDay = localSeconds() % SECONDS_PER_DAY;
+    if (secondOfDay < 0) {
+        secondOfDay += SECONDS_PER_DAY;
+    }
+    const int seconds = static_cast<int>(secondOfDay);
+    return Time(seconds / 3600, seconds / 60 % 60, seconds % 60);
+}
+
+void WallClock::refresh() {
+    publish(std::time(nullptr));
+}
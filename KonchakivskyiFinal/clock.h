@@ -0,0 +1,37 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "datetime.h"
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+// Process-wide cache of the local wall-clock date and time. Readers only call
+// time(), which is cheap, and reuse the published UTC offset while the second
+// has not changed; the offset is re-derived through the C library at most once
+// per second (or on refresh()). The snapshot is a single atomic word, so
+// readers never lock.
+class WallClock {
+private:
+    // Bits 18..63: the UTC second the offset was computed for.
+    // Bits 0..17:  UTC offset in seconds, biased by OFFSET_BIAS.
+    static std::atomic<std::uint64_t> snapshot;
+
+    static constexpr int OFFSET_BITS = 18;
+    static constexpr std::int64_t OFFSET_BIAS = std::int64_t(1) << (OFFSET_BITS - 1);
+
+    static std::uint64_t publish(std::time_t utc);
+    static std::int64_t localSeconds();
+
+public:
+    static Date today();
+    static Time now();
+
+    // Re-reads the timezone offset immediately, e.g. after changing TZ.
+    static void refresh();
+
+    // Portable localtime_s/localtime_r.
+    static bool toLocalTime(std::time_t utc, std::tm& result);
+};
+
+#endif
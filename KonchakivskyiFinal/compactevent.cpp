@@ -0,0 +1,96 @@
+#include "compactevent.h"
+#include <string>
+
+CompactEvent::CompactEvent(const DateTime& when, EventType type, EventPriority priority,
+    std::uint32_t title, std::uint32_t description)
+    : day(static_cast<std::int32_t>(when.getValue() >> TIME_BITS)),
+      timeTypePriority(static_cast<std::uint32_t>(when.getValue() & TIME_MASK) |
+          static_cast<std::uint32_t>(type) << TIME_BITS |
+          static_cast<std::uint32_t>(priority) << 25),
+      title(title),
+      description(description) {}
+
+Event CompactEvent::toEvent(std::string_view titleText, std::string_view descriptionText) const {
+    const DateTime when = getDateTime();
+    const std::string titleCopy(titleText);
+    const std::string descriptionCopy(descriptionText);
+    if (when.hasTime()) {
+        return Event(when.getDate(), when.getTime(), titleCopy, getType(), getPriority(), descriptionCopy);
+    }
+    return Event(when.getDate(), titleCopy, getType(), getPriority(), descriptionCopy);
+}
+
+CompactRule::CompactRule(const CompactEvent& first, const RecurrenceRule& rule, std::uint32_t firstException)
+    : first(first),
+      interval(rule.getInterval()),
+      count(rule.getCount()),
+      until(rule.getUntil() ? rule.getUntil()->toDayNumber() : 0),
+      frequency(static_cast<std::uint8_t>(rule.getFrequency())),
+      weekdays(rule.getWeekdays()),
+      hasUntil(rule.getUntil() ? 1 : 0),
+      firstException(firstException),
+      exceptionCount(static_cast<std::uint32_t>(rule.getExceptions().size())) {}
+
+RecurrenceRule CompactRule::toRule(std::span<const std::int32_t> exceptionDays) const {
+    const auto kind = frequency <= static_cast<std::uint8_t>(RecurrenceRule::Frequency::YEARLY)
+        ? static_cast<RecurrenceRule::Frequency>(frequency) : RecurrenceRule::Frequency::DAILY;
+    RecurrenceRule rule(kind, interval);
+    rule.setCount(count);
+    if (hasUntil != 0) {
+        rule.setUntil(Date::fromDayNumber(until));
+    }
+    for (int day = 0; day < 7; day++) {
+        if ((weekdays & (1u << day)) != 0) {
+            rule.onWeekday(day);
+        }
+    }
+    if (firstException <= exceptionDays.size() && exceptionCount <= exceptionDays.size() - firstException) {
+        for (const std::int32_t day : exceptionDays.subspan(firstException, exceptionCount)) {
+            rule.except(Date::fromDayNumber(day));
+        }
+    }
+    return rule;
+}
+
+CompactEventStore::CompactEventStore(const Calendar& calendar) {
+    const EventFilter all = calendar.getAllEvents();
+    events.reserve(all.count());
+    for (const Event& event : all) {
+        add(event);
+    }
+    for (const Calendar::RecurringEvent& series : calendar.getRecurringEvents()) {
+        addRecurring(series.event, series.rule);
+    }
+}
+
+CompactEvent CompactEventStore::compact(const Event& event) {
+    return CompactEvent(event.getDateTime(), event.getType(), event.getPriority(),
+        strings.intern(event.getTitle()), strings.intern(event.getDescription()));
+}
+
+void CompactEventStore::add(const Event& event) {
+    events.push_back(compact(event));
+}
+
+void CompactEventStore::addRecurring(const Event& first, const RecurrenceRule& rule) {
+    rules.emplace_back(compact(first), rule, static_cast<std::uint32_t>(exceptionDays.size()));
+    for (const Date& date : rule.getExceptions()) {
+        exceptionDays.push_back(date.toDayNumber());
+    }
+}
+
+Event CompactEventStore::toEvent(std::size_t index) const {
+    const CompactEvent& event = events[index];
+    return event.toEvent(getTitle(event), getDescription(event));
+}
+
+Calendar::RecurringEvent CompactEventStore::toRecurringEvent(std::size_t index) const {
+    const CompactEvent& first = rules[index].getFirst();
+    return Calendar::RecurringEvent{ first.toEvent(getTitle(first), getDescription(first)),
+        rules[index].toRule(exceptionDays) };
+}
+
+std::size_t CompactEventStore::memoryUsage() const {
+    return sizeof(*this) - sizeof(strings) + events.capacity() * sizeof(CompactEvent) +
+        rules.capacity() * sizeof(CompactRule) + exceptionDays.capacity() * sizeof(std::int32_t) + strings.memoryUsage();
+}
@@ -0,0 +1,128 @@
+#ifndef COMPACTEVENT_H
+#define COMPACTEVENT_H
+
+#include "calendar.h"
+#include "recurrence.h"
+#include "stringpool.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// An Event in 16 bytes instead of sizeof(Event) plus two heap strings: the
+// day number, the 17-bit time of day of DateTime, type and priority, and two
+// StringPool handles for the title and description. The type gets 8 bits and
+// the priority the 7 left over, which keeps the record at four words.
+class CompactEvent {
+private:
+    std::int32_t day;
+    std::uint32_t timeTypePriority;  // time in bits 0-16, type 17-24, priority 25-31
+    std::uint32_t title;
+    std::uint32_t description;
+
+    static constexpr int TIME_BITS = 17;
+    static constexpr std::uint32_t TIME_MASK = (std::uint32_t(1) << TIME_BITS) - 1;
+
+public:
+    CompactEvent(const DateTime& when, EventType type, EventPriority priority,
+        std::uint32_t title, std::uint32_t description);
+
+    DateTime getDateTime() const {
+        return DateTime::fromValue((std::int64_t(day) << TIME_BITS) | (timeTypePriority & TIME_MASK));
+    }
+    Date getDate() const { return Date::fromDayNumber(day); }
+    // Values past OTHER and HIGH, which only a damaged snapshot holds, read as
+    // those, so they never index past the per-type or per-priority tables.
+    EventType getType() const {
+        return static_cast<EventType>(std::min(timeTypePriority >> TIME_BITS & 0xFF, std::uint32_t(EventType::OTHER)));
+    }
+    EventPriority getPriority() const {
+        return static_cast<EventPriority>(std::min(timeTypePriority >> 25, std::uint32_t(EventPriority::HIGH)));
+    }
+    std::uint32_t getTitle() const { return title; }
+    std::uint32_t getDescription() const { return description; }
+    // The full Event, given the strings its handles refer to.
+    Event toEvent(std::string_view titleText, std::string_view descriptionText) const;
+};
+
+// Snapshots write and map the records as raw bytes.
+static_assert(sizeof(CompactEvent) == 16 && std::is_trivially_copyable_v<CompactEvent>);
+
+// A recurring event in 40 bytes: the CompactEvent of its first occurrence and
+// the fields of its RecurrenceRule. The exception dates are a run of day
+// numbers in an array kept next to the records, given by its start and
+// length.
+class CompactRule {
+private:
+    CompactEvent first;
+    std::int32_t interval;
+    std::uint32_t count;
+    std::int32_t until;           // day number, if hasUntil
+    std::uint8_t frequency;
+    std::uint8_t weekdays;
+    std::uint8_t hasUntil;
+    std::uint8_t reserved = 0;
+    std::uint32_t firstException;
+    std::uint32_t exceptionCount;
+
+public:
+    CompactRule(const CompactEvent& first, const RecurrenceRule& rule, std::uint32_t firstException);
+
+    const CompactEvent& getFirst() const { return first; }
+    std::uint32_t getFirstException() const { return firstException; }
+    std::uint32_t getExceptionCount() const { return exceptionCount; }
+    // The rule, with its exceptions taken from exceptionDays. A run that does
+    // not fit in exceptionDays is left out and an unknown frequency read as
+    // DAILY, so a damaged record gives a wrong rule, never a bad read.
+    RecurrenceRule toRule(std::span<const std::int32_t> exceptionDays) const;
+};
+
+static_assert(sizeof(CompactRule) == 40 && std::is_trivially_copyable_v<CompactRule>);
+
+// A read-only, memory-compact copy of a list of events. Titles and
+// descriptions are interned, so repeated text is stored once. Events keep the
+// order they were added in; built from a Calendar that is date order.
+// Recurring events are kept apart as rules; size() and getEvents() cover the
+// single events only.
+class CompactEventStore {
+private:
+    std::vector<CompactEvent> events;
+    std::vector<CompactRule> rules;
+    std::vector<std::int32_t> exceptionDays;  // the rules' runs, back to back
+    StringPool strings;
+
+    CompactEvent compact(const Event& event);
+
+public:
+    CompactEventStore() = default;
+    explicit CompactEventStore(const Calendar& calendar);
+
+    void add(const Event& event);
+    void addRecurring(const Event& first, const RecurrenceRule& rule);
+    void reserve(std::size_t count) { events.reserve(count); }
+    void shrinkToFit() { events.shrink_to_fit(); }
+
+    std::size_t size() const { return events.size(); }
+    bool empty() const { return events.empty(); }
+    const CompactEvent& operator[](std::size_t index) const { return events[index]; }
+    std::span<const CompactEvent> getEvents() const { return events; }
+    const StringPool& getStrings() const { return strings; }
+    std::string_view getTitle(const CompactEvent& event) const { return strings.get(event.getTitle()); }
+    std::string_view getDescription(const CompactEvent& event) const { return strings.get(event.getDescription()); }
+    // Rebuilds the full Event, copying its strings out of the pool.
+    Event toEvent(std::size_t index) const;
+
+    std::span<const CompactRule> getRules() const { return rules; }
+    std::span<const std::int32_t> getExceptionDays() const { return exceptionDays; }
+    Calendar::RecurringEvent toRecurringEvent(std::size_t index) const;
+
+    std::size_t distinctStrings() const { return strings.size(); }
+    // Approximate bytes held, including the rules, the string pool and its
+    // hash table.
+    std::size_t memoryUsage() const;
+};
+
+#endif
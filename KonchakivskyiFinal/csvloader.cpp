@@ -0,0 +1,354 @@
+#include "csvloader.h"
+#include "datebatch.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+// A record whose date field was well formed. Its date is only checked once
+// the whole chunk is parsed, in one DateBatch::convert call; until then its
+// event, if it has one, carries a placeholder date.
+struct DatedRecord {
+    std::size_t line;
+    const char* error;  // why a later field was rejected; nullptr if none
+};
+
+struct ChunkResult {
+    std::vector<Event> events;
+    std::vector<CsvLoader::Rejection> rejected;  // lines relative to the chunk
+    std::size_t lines = 0;                       // newlines in the chunk
+    const char* stop = nullptr;                  // just after its last record
+    std::vector<int> days, months, years;        // one per dated record
+    std::vector<DatedRecord> dated;
+};
+
+static constexpr std::size_t MAX_FIELDS = 6;
+
+static bool equalsIgnoreCase(std::string_view text, std::string_view name) {
+    if (text.size() != name.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < text.size(); i++) {
+        const char a = text[i] >= 'A' && text[i] <= 'Z' ? static_cast<char>(text[i] - 'A' + 'a') : text[i];
+        const char b = name[i] >= 'A' && name[i] <= 'Z' ? static_cast<char>(name[i] - 'A' + 'a') : name[i];
+        if (a != b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// The names Event::eventTypeToString and eventPriorityToString print.
+static bool parseType(std::string_view text, EventType& type) {
+    static const std::pair<std::string_view, EventType> names[] = {
+        { "Meeting", EventType::MEETING }, { "Birthday", EventType::BIRTHDAY },
+        { "Holiday", EventType::HOLIDAY }, { "Other", EventType::OTHER }
+    };
+    for (const auto& [name, candidate] : names) {
+        if (equalsIgnoreCase(text, name)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parsePriority(std::string_view text, EventPriority& priority) {
+    static const std::pair<std::string_view, EventPriority> names[] = {
+        { "Low", EventPriority::LOW }, { "Medium", EventPriority::MEDIUM }, { "High", EventPriority::HIGH }
+    };
+    for (const auto& [name, candidate] : names) {
+        if (equalsIgnoreCase(text, name)) {
+            priority = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The D/M/Y fields of a date as Date::parse reads them, without the range
+// check; false if the text is malformed.
+static bool splitDate(std::string_view text, int& day, int& month, int& year) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    return detail::parseNumberField(it, end, 2, day) && detail::parseSeparator(it, end, '/') &&
+        detail::parseNumberField(it, end, 2, month) && detail::parseSeparator(it, end, '/') &&
+        detail::parseNumberField(it, end, 4, year) && it == end;
+}
+
+// Checks one record's fields other than the date's range and adds its event,
+// or returns why it was rejected.
+static const char* checkRecord(const std::string_view* fields, std::size_t count, std::vector<Event>& events) {
+    const Date date = Date::fromDayNumber(0);  // replaced once dates are checked
+    const std::string_view timeText = trim(fields[1]);
+    Time time(0, 0, 0);
+    if (!timeText.empty()) {
+        switch (Time::parse(timeText, time)) {
+        case ParseError::None: break;
+        case ParseError::InvalidFormat: return "malformed time";
+        default: return "invalid time";
+        }
+    }
+    EventType type;
+    if (!parseType(trim(fields[3]), type)) {
+        return "unknown type";
+    }
+    EventPriority priority;
+    if (!parsePriority(trim(fields[4]), priority)) {
+        return "unknown priority";
+    }
+
+    const std::string title(fields[2]);
+    const std::string description(count == MAX_FIELDS ? fields[5] : std::string_view());
+    if (timeText.empty()) {
+        events.emplace_back(date, title, type, priority, description);
+    }
+    else {
+        events.emplace_back(date, time, title, type, priority, description);
+    }
+    return nullptr;
+}
+
+// Checks every dated record's date in one batch. An invalid date is reported
+// ahead of any other problem in the record, as Date::parse would have been.
+static void resolveDates(ChunkResult& result) {
+    const std::size_t count = result.dated.size();
+    std::vector<std::uint8_t> valid(count);
+    std::vector<int> dayNumbers(count);
+    std::vector<std::uint8_t> weekdays(count);
+    DateBatch::convert(result.days.data(), result.months.data(), result.years.data(), count,
+        valid.data(), dayNumbers.data(), weekdays.data());
+
+    std::size_t next = 0;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        const DatedRecord& record = result.dated[i];
+        if (record.error == nullptr) {
+            Event& event = result.events[next++];
+            if (valid[i]) {
+                event.setDate(Date::fromDayNumber(dayNumbers[i]));
+                if (kept != next - 1) {
+                    result.events[kept] = std::move(event);
+                }
+                kept++;
+                continue;
+            }
+        }
+        result.rejected.push_back(CsvLoader::Rejection{ record.line, valid[i] ? record.error : "invalid date" });
+    }
+    result.events.erase(result.events.begin() + kept, result.events.end());
+    std::sort(result.rejected.begin(), result.rejected.end(),
+        [](const CsvLoader::Rejection& a, const CsvLoader::Rejection& b) { return a.line < b.line; });
+}
+
+// Parses the records that start in [p, cut); p is on a record boundary. The
+// last record may run on past cut, up to end (the end of the file), exactly
+// as it would in a parse of the whole file; result.stop says where it ended.
+static void parseChunk(const char* p, const char* cut, const char* end, bool skipHeader, ChunkResult& result) {
+    std::string_view fields[MAX_FIELDS];
+    std::string unquoted[MAX_FIELDS];  // quoted fields with "" pairs, undoubled
+    std::size_t line = 0;
+
+    while (p < cut) {
+        const std::size_t recordLine = line;
+        std::size_t count = 0;
+        const char* error = nullptr;
+
+        for (;;) {
+            std::string_view field;
+            if (p < end && *p == '"') {
+                // Quoted: runs to the quote not followed by another quote.
+                const char* start = ++p;
+                std::string* owned = nullptr;
+                for (;;) {
+                    const char* quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+                    if (quote == nullptr) {
+                        line += std::count(p, end, '\n');
+                        p = end;
+                        error = "unterminated quote";
+                        break;
+                    }
+                    line += std::count(p, quote, '\n');
+                    if (quote + 1 < end && quote[1] == '"') {
+                        if (owned == nullptr && count < MAX_FIELDS) {
+                            owned = &unquoted[count];
+                            owned->clear();
+                        }
+                        if (owned != nullptr) {
+                            owned->append(start, quote + 1);
+                        }
+                        p = start = quote + 2;
+                        continue;
+                    }
+                    if (owned != nullptr) {
+                        owned->append(start, quote);
+                        field = *owned;
+                    }
+                    else {
+                        field = std::string_view(start, static_cast<std::size_t>(quote - start));
+                    }
+                    p = quote + 1;
+                    break;
+                }
+                if (error != nullptr) {
+                    break;
+                }
+                if (p < end && *p == '\r' && p + 1 < end && p[1] == '\n') {
+                    p++;
+                }
+                if (p < end && *p != ',' && *p != '\n') {
+                    error = "text after closing quote";
+                }
+            }
+            else {
+                const char* start = p;
+                while (p < end && *p != ',' && *p != '\n') {
+                    if (*p == '"') {
+                        error = "quote inside unquoted field";
+                    }
+                    p++;
+                }
+                const char* fieldEnd = p;
+                if (p < end && *p == '\n' && fieldEnd > start && fieldEnd[-1] == '\r') {
+                    fieldEnd--;
+                }
+                field = std::string_view(start, static_cast<std::size_t>(fieldEnd - start));
+            }
+
+            if (count < MAX_FIELDS) {
+                fields[count] = field;
+            }
+            count++;
+            if (error != nullptr || p >= end || *p == '\n') {
+                break;
+            }
+            p++;  // the comma
+        }
+
+        if (error != nullptr) {
+            // Resynchronise on the next line.
+            while (p < end && *p != '\n') {
+                p++;
+            }
+        }
+        if (p < end) {
+            p++;  // the newline
+            line++;
+        }
+
+        const bool blank = error == nullptr && count == 1 && fields[0].empty();
+        const bool header = skipHeader && recordLine == 0 && error == nullptr &&
+            equalsIgnoreCase(trim(fields[0]), "date");
+        if (blank || header) {
+            continue;
+        }
+        int day = 0, month = 0, year = 0;
+        if (error == nullptr && (count < 5 || count > MAX_FIELDS)) {
+            error = "wrong number of fields";
+        }
+        if (error == nullptr && !splitDate(trim(fields[0]), day, month, year)) {
+            error = "malformed date";
+        }
+        if (error != nullptr) {
+            result.rejected.push_back(CsvLoader::Rejection{ recordLine, error });
+            continue;
+        }
+        result.days.push_back(day);
+        result.months.push_back(month);
+        result.years.push_back(year);
+        result.dated.push_back(DatedRecord{ recordLine, checkRecord(fields, count, result.events) });
+    }
+    result.lines = line;
+    result.stop = p;
+    resolveDates(result);
+    std::stable_sort(result.events.begin(), result.events.end());
+}
+
+// The first record boundary at or after at: a position just after a newline
+// that is not inside quotes. quoted is the quote parity of data before at.
+static std::size_t recordStart(const char* data, std::size_t size, std::size_t at, bool quoted) {
+    if (at == 0) {
+        return 0;
+    }
+    std::size_t i = at - 1;
+    quoted ^= data[i] == '"';
+    for (; i < size; i++) {
+        if (data[i] == '\n' && !quoted) {
+            return i + 1;
+        }
+        if (data[i] == '"') {
+            quoted = !quoted;
+        }
+    }
+    return size;
+}
+
+CsvLoader::Result CsvLoader::load(Calendar& calendar, const std::string& path) {
+    const MappedFile file(path);
+    const char* data = file.getData();
+    const std::size_t size = file.getSize();
+    Result result;
+    if (size == 0) {
+        return result;
+    }
+
+    // Cut at even offsets, count the quotes before each cut in parallel, then
+    // move every cut forward to the next newline outside quotes.
+    const std::size_t chunkCount = size / chunkSize + (size % chunkSize != 0 ? 1 : 0);
+    std::vector<std::size_t> quotes(chunkCount);
+    pool.parallelFor(chunkCount, [&](std::size_t chunk) {
+        const char* from = data + chunk * size / chunkCount;
+        const char* to = data + (chunk + 1) * size / chunkCount;
+        quotes[chunk] = static_cast<std::size_t>(std::count(from, to, '"'));
+    });
+    std::vector<std::size_t> starts(chunkCount + 1, size);
+    bool quoted = false;
+    for (std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+        starts[chunk] = recordStart(data, size, chunk * size / chunkCount, quoted);
+        quoted ^= (quotes[chunk] & 1) != 0;
+    }
+
+    std::vector<ChunkResult> chunks(chunkCount);
+    pool.parallelFor(chunkCount, [&](std::size_t chunk) {
+        parseChunk(data + starts[chunk], data + starts[chunk + 1], data + size, chunk == 0, chunks[chunk]);
+    });
+
+    // Quote parity only finds the true record boundaries in a well-formed
+    // file. The parser recovers from a stray or unterminated quote the way a
+    // sequential parse would, so after one the previous chunk can stop
+    // somewhere other than the cut. Such a chunk is parsed again from where
+    // the previous one really stopped; the fix-ups run in file order.
+    for (std::size_t chunk = 1; chunk < chunkCount; chunk++) {
+        const std::size_t stop = static_cast<std::size_t>(chunks[chunk - 1].stop - data);
+        if (stop != starts[chunk]) {
+            starts[chunk] = stop;
+            chunks[chunk] = ChunkResult();
+            parseChunk(data + stop, data + std::max(stop, starts[chunk + 1]), data + size, false, chunks[chunk]);
+        }
+    }
+
+    std::vector<std::vector<Event>> batches;
+    batches.reserve(chunkCount);
+    std::size_t firstLine = 1;
+    for (ChunkResult& chunk : chunks) {
+        for (const Rejection& rejection : chunk.rejected) {
+            result.rejected.push_back(Rejection{ firstLine + rejection.line, rejection.reason });
+        }
+        firstLine += chunk.lines;
+        result.loaded += chunk.events.size();
+        batches.push_back(std::move(chunk.events));
+    }
+    calendar.addSortedBatches(batches);
+    return result;
+}
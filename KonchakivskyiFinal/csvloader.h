@@ -0,0 +1,59 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include "calendar.h"
+#include "threadpool.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Bulk-loads events from a CSV file (RFC 4180 quoting) with the columns
+//
+//     date,time,title,type,priority[,description]
+//
+// date is D/M/Y and time H:M:S, read as Date::parse and Time::parse read
+// them, so the validity rules are those of Date::isValidDate and
+// Time::isValidTime; an empty time makes an all-day event. Each chunk's dates
+// are range-checked together with DateBatch::convert. type and priority are the names
+// Event prints ("Meeting", "High", ...), in any case. A first line starting
+// with "date" is taken as a header and skipped, as are blank lines.
+//
+// The file is mapped and cut into chunks on record boundaries (quote parity
+// is counted per chunk first, so quoted newlines never split a record). Each
+// chunk is parsed and sorted on the pool into its own batch, and the batches
+// are merged into the calendar in one pass (Calendar::addSortedBatches).
+// Bad rows are reported and skipped; the rest of the file still loads. A
+// stray quote can throw the parity off, so a chunk whose predecessor did not
+// stop at its cut is parsed again from where it did: the result is always
+// that of parsing the file in one piece, whatever the chunk size.
+class CsvLoader {
+public:
+    struct Rejection {
+        std::size_t line;    // 1-based line the record starts on
+        const char* reason;
+    };
+
+    struct Result {
+        std::size_t loaded = 0;
+        std::vector<Rejection> rejected;  // in file order
+    };
+
+private:
+    ThreadPool pool;
+    std::size_t chunkSize;
+
+public:
+    static constexpr std::size_t CHUNK_SIZE = 4 << 20;
+
+    // threads == 0 uses every hardware thread. A chunkSize of at least the
+    // file size parses it in one piece.
+    explicit CsvLoader(unsigned threads = 0, std::size_t chunkSize = CHUNK_SIZE)
+        : pool(threads), chunkSize(chunkSize == 0 ? 1 : chunkSize) {}
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    // Throws std::runtime_error if the file cannot be read.
+    Result load(Calendar& calendar, const std::string& path);
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "datebatch.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DATEBATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DATEBATCH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DATEBATCH_TARGET(isa)
+#endif
+
+static void convertScalar(const int* days, const int* months, const int* years, std::size_t count,
+    std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays) {
+    for (std::size_t i = 0; i < count; i++) {
+        if (Date::isValidDate(days[i], months[i], years[i])) {
+            Date date(days[i], months[i], years[i]);
+            valid[i] = 1;
+            dayNumbers[i] = date.toDayNumber();
+            weekdays[i] = static_cast<std::uint8_t>(date.getDayOfWeekNumber());
+        }
+        else {
+            valid[i] = 0;
+            dayNumbers[i] = 0;
+            weekdays[i] = 0;
+        }
+    }
+}
+
+#ifdef DATEBATCH_X86
+
+// The vector kernels assume a valid year (1..9999), so every division is a
+// multiply and shift that is exact on that range:
+//   y / 100 == (y * 5243) >> 19,  y / 400 == (y * 5243) >> 21,
+//   x / 5 == (x * 6554) >> 15 for x <= 1685,  s / 7 == (s * 37450) >> 18 for s < 14000.
+// Lanes with garbage input compute garbage and are masked to zero at the end.
+// The day number is days_from_civil with no era split, because the shifted
+// year is never negative. The weekday uses 365 == 1 (mod 7), so it needs
+// only the small terms of that sum.
+
+DATEBATCH_TARGET("sse4.1")
+static void convertSSE41(const int* days, const int* months, const int* years, std::size_t count,
+    std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i allOnes = _mm_set1_epi32(-1);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(days + i));
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(months + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(years + i));
+
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi32(d, zero), _mm_cmpgt_epi32(m, zero));
+        ok = _mm_and_si128(ok, _mm_cmplt_epi32(m, _mm_set1_epi32(13)));
+        ok = _mm_and_si128(ok, _mm_cmpgt_epi32(y, zero));
+        ok = _mm_and_si128(ok, _mm_cmplt_epi32(y, _mm_set1_epi32(Date::MAX_YEAR + 1)));
+
+        const __m128i y5243 = _mm_mullo_epi32(y, _mm_set1_epi32(5243));
+        const __m128i r100 = _mm_sub_epi32(y, _mm_mullo_epi32(_mm_srli_epi32(y5243, 19), _mm_set1_epi32(100)));
+        const __m128i r400 = _mm_sub_epi32(y, _mm_mullo_epi32(_mm_srli_epi32(y5243, 21), _mm_set1_epi32(400)));
+        const __m128i divisibleBy4 = _mm_cmpeq_epi32(_mm_and_si128(y, _mm_set1_epi32(3)), zero);
+        const __m128i notCentury = _mm_andnot_si128(_mm_cmpeq_epi32(r100, zero), allOnes);
+        const __m128i leap = _mm_and_si128(divisibleBy4, _mm_or_si128(notCentury, _mm_cmpeq_epi32(r400, zero)));
+
+        // 30 or 31 alternating, with the parity flipping after July; February is 28 + leap.
+        const __m128i dimOther = _mm_or_si128(_mm_set1_epi32(30), _mm_and_si128(_mm_xor_si128(m, _mm_srli_epi32(m, 3)), one));
+        const __m128i dimFeb = _mm_sub_epi32(_mm_set1_epi32(28), leap);
+        const __m128i dim = _mm_blendv_epi8(dimOther, dimFeb, _mm_cmpeq_epi32(m, _mm_set1_epi32(2)));
+        ok = _mm_andnot_si128(_mm_cmpgt_epi32(d, dim), ok);
+
+        const __m128i janFeb = _mm_cmplt_epi32(m, _mm_set1_epi32(3));
+        const __m128i yp = _mm_add_epi32(y, janFeb);
+        const __m128i mp = _mm_sub_epi32(_mm_add_epi32(m, _mm_set1_epi32(9)), _mm_andnot_si128(janFeb, _mm_set1_epi32(12)));
+        const __m128i monthDays = _mm_srli_epi32(_mm_mullo_epi32(_mm_add_epi32(_mm_mullo_epi32(mp, _mm_set1_epi32(153)), _mm_set1_epi32(2)), _mm_set1_epi32(6554)), 15);
+
+        const __m128i yp5243 = _mm_mullo_epi32(yp, _mm_set1_epi32(5243));
+        __m128i base = _mm_sub_epi32(_mm_srli_epi32(yp, 2), _mm_srli_epi32(yp5243, 19));
+        base = _mm_add_epi32(base, _mm_srli_epi32(yp5243, 21));
+        base = _mm_add_epi32(base, _mm_add_epi32(monthDays, d));
+
+        const __m128i serial = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(yp, _mm_set1_epi32(365)), base), _mm_set1_epi32(-1 - 719468));
+        const __m128i s = _mm_add_epi32(_mm_add_epi32(yp, base), _mm_set1_epi32(2));
+        const __m128i weekday = _mm_sub_epi32(s, _mm_mullo_epi32(_mm_srli_epi32(_mm_mullo_epi32(s, _mm_set1_epi32(37450)), 18), _mm_set1_epi32(7)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dayNumbers + i), _mm_and_si128(serial, ok));
+
+        const __m128i validBytes = _mm_packus_epi16(_mm_packs_epi32(_mm_and_si128(ok, one), zero), zero);
+        const __m128i weekdayBytes = _mm_packus_epi16(_mm_packs_epi32(_mm_and_si128(weekday, ok), zero), zero);
+        const int validBits = _mm_cvtsi128_si32(validBytes);
+        const int weekdayBits = _mm_cvtsi128_si32(weekdayBytes);
+        std::memcpy(valid + i, &validBits, 4);
+        std::memcpy(weekdays + i, &weekdayBits, 4);
+    }
+
+    convertScalar(days + i, months + i, years + i, count - i, valid + i, dayNumbers + i, weekdays + i);
+}
+
+DATEBATCH_TARGET("avx2")
+static void convertAVX2(const int* days, const int* months, const int* years, std::size_t count,
+    std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(days + i));
+        const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(months + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(years + i));
+
+        __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi32(d, zero), _mm256_cmpgt_epi32(m, zero));
+        ok = _mm256_and_si256(ok, _mm256_cmpgt_epi32(_mm256_set1_epi32(13), m));
+        ok = _mm256_and_si256(ok, _mm256_cmpgt_epi32(y, zero));
+        ok = _mm256_and_si256(ok, _mm256_cmpgt_epi32(_mm256_set1_epi32(Date::MAX_YEAR + 1), y));
+
+        const __m256i y5243 = _mm256_mullo_epi32(y, _mm256_set1_epi32(5243));
+        const __m256i r100 = _mm256_sub_epi32(y, _mm256_mullo_epi32(_mm256_srli_epi32(y5243, 19), _mm256_set1_epi32(100)));
+        const __m256i r400 = _mm256_sub_epi32(y, _mm256_mullo_epi32(_mm256_srli_epi32(y5243, 21), _mm256_set1_epi32(400)));
+        const __m256i divisibleBy4 = _mm256_cmpeq_epi32(_mm256_and_si256(y, _mm256_set1_epi32(3)), zero);
+        const __m256i notCentury = _mm256_andnot_si256(_mm256_cmpeq_epi32(r100, zero), allOnes);
+        const __m256i leap = _mm256_and_si256(divisibleBy4, _mm256_or_si256(notCentury, _mm256_cmpeq_epi32(r400, zero)));
+
+        const __m256i dimOther = _mm256_or_si256(_mm256_set1_epi32(30), _mm256_and_si256(_mm256_xor_si256(m, _mm256_srli_epi32(m, 3)), one));
+        const __m256i dimFeb = _mm256_sub_epi32(_mm256_set1_epi32(28), leap);
+        const __m256i dim = _mm256_blendv_epi8(dimOther, dimFeb, _mm256_cmpeq_epi32(m, _mm256_set1_epi32(2)));
+        ok = _mm256_andnot_si256(_mm256_cmpgt_epi32(d, dim), ok);
+
+        const __m256i janFeb = _mm256_cmpgt_epi32(_mm256_set1_epi32(3), m);
+        const __m256i yp = _mm256_add_epi32(y, janFeb);
+        const __m256i mp = _mm256_sub_epi32(_mm256_add_epi32(m, _mm256_set1_epi32(9)), _mm256_andnot_si256(janFeb, _mm256_set1_epi32(12)));
+        const __m256i monthDays = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(mp, _mm256_set1_epi32(153)), _mm256_set1_epi32(2)), _mm256_set1_epi32(6554)), 15);
+
+        const __m256i yp5243 = _mm256_mullo_epi32(yp, _mm256_set1_epi32(5243));
+        __m256i base = _mm256_sub_epi32(_mm256_srli_epi32(yp, 2), _mm256_srli_epi32(yp5243, 19));
+        base = _mm256_add_epi32(base, _mm256_srli_epi32(yp5243, 21));
+        base = _mm256_add_epi32(base, _mm256_add_epi32(monthDays, d));
+
+        const __m256i serial = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(yp, _mm256_set1_epi32(365)), base), _mm256_set1_epi32(-1 - 719468));
+        const __m256i s = _mm256_add_epi32(_mm256_add_epi32(yp, base), _mm256_set1_epi32(2));
+        const __m256i weekday = _mm256_sub_epi32(s, _mm256_mullo_epi32(_mm256_srli_epi32(_mm256_mullo_epi32(s, _mm256_set1_epi32(37450)), 18), _mm256_set1_epi32(7)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dayNumbers + i), _mm256_and_si256(serial, ok));
+
+        const __m256i validLanes = _mm256_and_si256(ok, one);
+        const __m256i weekdayLanes = _mm256_and_si256(weekday, ok);
+        const __m128i validWords = _mm_packs_epi32(_mm256_castsi256_si128(validLanes), _mm256_extracti128_si256(validLanes, 1));
+        const __m128i weekdayWords = _mm_packs_epi32(_mm256_castsi256_si128(weekdayLanes), _mm256_extracti128_si256(weekdayLanes, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(valid + i), _mm_packus_epi16(validWords, validWords));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(weekdays + i), _mm_packus_epi16(weekdayWords, weekdayWords));
+    }
+
+    convertScalar(days + i, months + i, years + i, count - i, valid + i, dayNumbers + i, weekdays + i);
+}
+
+static bool cpuSupports(DateBatch::Kernel kernel) {
+    if (kernel == DateBatch::Kernel::Scalar) {
+        return true;
+    }
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    if (kernel == DateBatch::Kernel::SSE41) {
+        return sse41;
+    }
+
+    const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+        (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesAvx || maxLeaf < 7) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (kernel == DateBatch::Kernel::SSE41) {
+        return __builtin_cpu_supports("sse4.1");
+    }
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+static bool cpuSupports(DateBatch::Kernel kernel) {
+    return kernel == DateBatch::Kernel::Scalar;
+}
+
+#endif
+
+DateBatch::Kernel DateBatch::bestKernel() {
+    static const Kernel best =
+        cpuSupports(Kernel::AVX2) ? Kernel::AVX2 :
+        cpuSupports(Kernel::SSE41) ? Kernel::SSE41 :
+        Kernel::Scalar;
+    return best;
+}
+
+const char* DateBatch::kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Kernel::Scalar: return "Scalar";
+    case Kernel::SSE41: return "SSE4.1";
+    case Kernel::AVX2: return "AVX2";
+    default: return "Unknown";
+    }
+}
+
+void DateBatch::convert(const int* days, const int* months, const int* years, std::size_t count,
+    std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays) {
+    convert(bestKernel(), days, months, years, count, valid, dayNumbers, weekdays);
+}
+
+void DateBatch::convert(Kernel kernel, const int* days, const int* months, const int* years, std::size_t count,
+    std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays) {
+    if (!cpuSupports(kernel)) {
+        kernel = bestKernel();
+    }
+
+    switch (kernel) {
+#ifdef DATEBATCH_X86
+    case Kernel::AVX2:
+        convertAVX2(days, months, years, count, valid, dayNumbers, weekdays);
+        break;
+    case Kernel::SSE41:
+        convertSSE41(days, months, years, count, valid, dayNumbers, weekdays);
+        break;
+#endif
+    default:
+        convertScalar(days, months, years, count, valid, dayNumbers, weekdays);
+        break;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef DATEBATCH_H
+#define DATEBATCH_H
+
+#include "datetime.h"
+#include <cstddef>
+#include <cstdint>
+
+// Converts many (day, month, year) triples at once. The inputs are three
+// parallel arrays. For each index i, the outputs are:
+//   valid[i]      - 1 if Date::isValidDate(days[i], months[i], years[i]), else 0
+//   dayNumbers[i] - Date(days[i], months[i], years[i]).toDayNumber(), or 0 if invalid
+//   weekdays[i]   - the matching getDayOfWeekNumber(), or 0 if invalid
+// Invalid entries do not fall back to today's date as the Date constructor does.
+class DateBatch {
+public:
+    enum class Kernel {
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    // Best kernel the running CPU supports; detected once.
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    static void convert(const int* days, const int* months, const int* years, std::size_t count,
+        std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays);
+
+    // Forces a kernel, e.g. for benchmarking. Falls back to bestKernel() if
+    // the CPU does not support the requested one.
+    static void convert(Kernel kernel, const int* days, const int* months, const int* years, std::size_t count,
+        std::uint8_t* valid, int* dayNumbers, std::uint8_t* weekdays);
+};
+
+#endif
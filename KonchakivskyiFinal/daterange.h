@@ -0,0 +1,111 @@
+#ifndef DATERANGE_H
+#define DATERANGE_H
+
+#include "datetime.h"
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+
+// A lazy half-open range of dates [first, last) stepping by days, weeks or
+// months. Dates are produced from day numbers without revalidation, so
+// walking a range costs about as much as an integer loop. The iterators are
+// random access and the range is a borrowed C++20 view, so it works with
+// range-based for and the std::ranges algorithms.
+class DateRange : public std::ranges::view_interface<DateRange> {
+public:
+    enum class Step {
+        Day,
+        Week,
+        Month
+    };
+
+    class iterator {
+    private:
+        int origin = 0;     // day number of the first date
+        int index = 0;
+        int stride = 1;     // in days, or in months when byMonth
+        bool byMonth = false;
+
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Date;
+        using difference_type = std::ptrdiff_t;
+        using reference = Date;
+
+        constexpr iterator() = default;
+        constexpr iterator(int origin, int index, int stride, bool byMonth)
+            : origin(origin), index(index), stride(stride), byMonth(byMonth) {}
+
+        constexpr Date operator*() const {
+            return byMonth
+                ? Date::fromDayNumber(origin).addMonths(index * stride)
+                : Date::fromDayNumber(origin + index * stride);
+        }
+        constexpr Date operator[](difference_type n) const { return *(*this + n); }
+
+        constexpr iterator& operator++() { ++index; return *this; }
+        constexpr iterator operator++(int) { iterator temp(*this); ++index; return temp; }
+        constexpr iterator& operator--() { --index; return *this; }
+        constexpr iterator operator--(int) { iterator temp(*this); --index; return temp; }
+
+        constexpr iterator& operator+=(difference_type n) { index += static_cast<int>(n); return *this; }
+        constexpr iterator& operator-=(difference_type n) { index -= static_cast<int>(n); return *this; }
+        constexpr iterator operator+(difference_type n) const { iterator result(*this); return result += n; }
+        constexpr iterator operator-(difference_type n) const { iterator result(*this); return result -= n; }
+        friend constexpr iterator operator+(difference_type n, const iterator& it) { return it + n; }
+        constexpr difference_type operator-(const iterator& other) const { return index - other.index; }
+
+        constexpr bool operator==(const iterator& other) const { return index == other.index; }
+        constexpr auto operator<=>(const iterator& other) const { return index <=> other.index; }
+    };
+
+private:
+    int origin = 0;
+    int count = 0;
+    int stride = 1;
+    bool byMonth = false;
+
+public:
+    constexpr DateRange() = default;
+    constexpr DateRange(const Date& first, const Date& last, Step step = Step::Day, int stepCount = 1)
+        : origin(first.toDayNumber()),
+        stride((stepCount < 1 ? 1 : stepCount) * (step == Step::Week ? 7 : 1)),
+        byMonth(step == Step::Month) {
+        const int span = last.toDayNumber() - origin;
+        if (span <= 0) {
+            count = 0;
+        }
+        else if (!byMonth) {
+            count = (span + stride - 1) / stride;
+        }
+        else {
+            // Every step covers 28-31 days per month, so start just below the
+            // estimate and walk up to the exact count.
+            count = span / (31 * stride);
+            while (first.addMonths(count * stride) < last) {
+                count++;
+            }
+        }
+    }
+
+    // All days of a month or a year.
+    static constexpr DateRange month(int month, int year) {
+        const Date first(1, month, year);
+        return DateRange(first, first.addMonths(1));
+    }
+    static constexpr DateRange year(int year) {
+        const Date first(1, 1, year);
+        return DateRange(first, first.addMonths(12));
+    }
+
+    constexpr iterator begin() const { return iterator(origin, 0, stride, byMonth); }
+    constexpr iterator end() const { return iterator(origin, count, stride, byMonth); }
+    constexpr std::size_t size() const { return static_cast<std::size_t>(count); }
+    constexpr bool empty() const { return count == 0; }
+};
+
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<DateRange> = true;
+
+#endif
@@ -3,54 +3,98 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+enum class ParseError {
+    None,
+    InvalidFormat,
+    InvalidValue
+};
 
 class Date {
 private:
-    int day;
-    int month;
-    int year;
+    // Days since 01/01/1970; day, month and year are decoded on demand.
+    int serial;
 
-    bool isValidDate(int d, int m, int y) const;
-    int daysInMonth(int m, int y) const;
-    bool isLeapYear(int y) const;
+    static constexpr int daysFromCivil(int d, int m, int y);
+    static constexpr void civilFromDays(int days, int& d, int& m, int& y);
 
 public:
+    static constexpr int MAX_YEAR = 9999;
+
+    struct DayInfo {
+        int weekday;        // 0 = Sunday, as getDayOfWeekNumber()
+        int dayOfYear;      // 1..366
+        int isoWeek;        // 1..53
+        int isoWeekYear;    // year the ISO week belongs to
+    };
+
     Date();
-    Date(int d, int m, int y);
-    Date(const Date& other);
+    constexpr Date(int d, int m, int y);
+    constexpr Date(const Date& other) = default;
+    constexpr Date& operator=(const Date& other) = default;
+
+    static constexpr bool isLeapYear(int y);
+    static constexpr int daysInMonth(int m, int y);
+    static constexpr bool isValidDate(int d, int m, int y);
 
-    int getDay() const { return day; }
-    int getMonth() const { return month; }
-    int getYear() const { return year; }
-    int getDaysInMonth(int m,int y) const {
+    static constexpr Date fromDayNumber(int days);
+    // The day number of any proleptic Gregorian date, without the range
+    // check (or the fallback to today) the constructor applies.
+    static constexpr int dayNumberOf(int d, int m, int y) { return daysFromCivil(d, m, y); }
+    constexpr int toDayNumber() const { return serial; }
+
+    constexpr int getDay() const;
+    constexpr int getMonth() const;
+    constexpr int getYear() const;
+    constexpr int getDaysInMonth(int m,int y) const {
         return daysInMonth(m, y);
     }
 
-    bool setDay(int d);
-    bool setMonth(int m);
-    bool setYear(int y);
-    bool setDate(int d, int m, int y);
+    constexpr bool setDay(int d);
+    constexpr bool setMonth(int m);
+    constexpr bool setYear(int y);
+    constexpr bool setDate(int d, int m, int y);
+
+    // Moves by whole months, clamping the day to the length of the target
+    // month (31/01 + 1 month is 28/02 or 29/02).
+    constexpr Date addMonths(int months) const;
 
     std::string getDayOfWeek() const;
-    int getDayOfWeekNumber() const;
-
-    Date& operator++();
-    Date operator++(int);
-    Date& operator--();
-    Date operator--(int);
-
-    Date& operator+=(int days);
-    Date& operator-=(int days);
-    Date operator+(int days) const;
-    Date operator-(int days) const;
-    int operator-(const Date& other) const;
-
-    bool operator==(const Date& other) const;
-    bool operator!=(const Date& other) const;
-    bool operator<(const Date& other) const;
-    bool operator>(const Date& other) const;
-    bool operator<=(const Date& other) const;
-    bool operator>=(const Date& other) const;
+    constexpr int getDayOfWeekNumber() const;
+    constexpr DayInfo getDayInfo() const;
+    constexpr int getDayOfYear() const;
+    constexpr int getIsoWeek() const;
+    constexpr int getIsoWeekYear() const;
+
+    constexpr Date& operator++();
+    constexpr Date operator++(int);
+    constexpr Date& operator--();
+    constexpr Date operator--(int);
+
+    constexpr Date& operator+=(int days);
+    constexpr Date& operator-=(int days);
+    constexpr Date operator+(int days) const;
+    constexpr Date operator-(int days) const;
+    constexpr int operator-(const Date& other) const;
+
+    constexpr bool operator==(const Date& other) const;
+    constexpr bool operator!=(const Date& other) const;
+    constexpr bool operator<(const Date& other) const;
+    constexpr bool operator>(const Date& other) const;
+    constexpr bool operator<=(const Date& other) const;
+    constexpr bool operator>=(const Date& other) const;
+
+    // formatTo writes "DD/MM/YYYY" without a terminator and returns the end
+    // of the output. Dates moved past the valid range by arithmetic print
+    // their year as is, so the buffer must hold FORMAT_SIZE chars.
+    static constexpr std::size_t FORMAT_SIZE = 17;
+    char* formatTo(char* buffer) const;
+    static constexpr ParseError parse(std::string_view text, Date& result);
 
     void display() const;
     std::string toString() const;
@@ -63,43 +107,613 @@ private:
     int minute;
     int second;
 
-    bool isValidTime(int h, int m, int s) const;
-
 public:
     Time();
-    Time(int h, int m, int s);
-    Time(const Time& other);
-
-    int getHour() const { return hour; }
-    int getMinute() const { return minute; }
-    int getSecond() const { return second; }
-
-    bool setHour(int h);
-    bool setMinute(int m);
-    bool setSecond(int s);
-    bool setTime(int h, int m, int s);
-
-    Time& operator++();
-    Time operator++(int);
-    Time& operator--();
-    Time operator--(int);
-
-    Time& operator+=(int seconds);
-    Time& operator-=(int seconds);
-    Time operator+(int seconds) const;
-    Time operator-(int seconds) const;
-    int operator-(const Time& other) const;
-
-    bool operator==(const Time& other) const;
-    bool operator!=(const Time& other) const;
-    bool operator<(const Time& other) const;
-    bool operator>(const Time& other) const;
-    bool operator<=(const Time& other) const;
-    bool operator>=(const Time& other) const;
+    constexpr Time(int h, int m, int s);
+    constexpr Time(const Time& other) = default;
+    constexpr Time& operator=(const Time& other) = default;
+
+    static constexpr bool isValidTime(int h, int m, int s);
+
+    constexpr int getHour() const { return hour; }
+    constexpr int getMinute() const { return minute; }
+    constexpr int getSecond() const { return second; }
+
+    constexpr bool setHour(int h);
+    constexpr bool setMinute(int m);
+    constexpr bool setSecond(int s);
+    constexpr bool setTime(int h, int m, int s);
+
+    constexpr Time& operator++();
+    constexpr Time operator++(int);
+    constexpr Time& operator--();
+    constexpr Time operator--(int);
+
+    constexpr Time& operator+=(int seconds);
+    constexpr Time& operator-=(int seconds);
+    constexpr Time operator+(int seconds) const;
+    constexpr Time operator-(int seconds) const;
+    constexpr int operator-(const Time& other) const;
+
+    constexpr bool operator==(const Time& other) const;
+    constexpr bool operator!=(const Time& other) const;
+    constexpr bool operator<(const Time& other) const;
+    constexpr bool operator>(const Time& other) const;
+    constexpr bool operator<=(const Time& other) const;
+    constexpr bool operator>=(const Time& other) const;
+
+    // "HH:MM:SS", no terminator.
+    static constexpr std::size_t FORMAT_SIZE = 8;
+    char* formatTo(char* buffer) const;
+    static constexpr ParseError parse(std::string_view text, Time& result);
 
     void display() const;
     std::string toString() const;
     friend std::ostream& operator<<(std::ostream& os, const Time& time);
 };
 
-#endif
\ No newline at end of file
+// A date and an optional time of day packed into one 64-bit integer:
+// (day number << 17) | (second of day + 1), with 0 in the low bits meaning
+// "all day". All-day values sort before any time on the same date, matching
+// Event ordering, so comparing and hashing are single integer operations.
+class DateTime {
+private:
+    std::int64_t value;
+
+    static constexpr int TIME_BITS = 17;
+    static constexpr std::int64_t TIME_MASK = (std::int64_t(1) << TIME_BITS) - 1;
+
+    constexpr explicit DateTime(std::int64_t packed) : value(packed) {}
+
+public:
+    constexpr explicit DateTime(const Date& date)
+        : value(std::int64_t(date.toDayNumber()) << TIME_BITS) {}
+    constexpr DateTime(const Date& date, const Time& time)
+        : value((std::int64_t(date.toDayNumber()) << TIME_BITS) +
+            time.getHour() * 3600 + time.getMinute() * 60 + time.getSecond() + 1) {}
+
+    static constexpr DateTime fromValue(std::int64_t packed) { return DateTime(packed); }
+    constexpr std::int64_t getValue() const { return value; }
+    // Unsigned key with the same ordering, for radix sorts.
+    constexpr std::uint64_t sortKey() const { return static_cast<std::uint64_t>(value) ^ (std::uint64_t(1) << 63); }
+
+    constexpr Date getDate() const { return Date::fromDayNumber(static_cast<int>(value >> TIME_BITS)); }
+    constexpr bool hasTime() const { return (value & TIME_MASK) != 0; }
+    // 00:00:00 for all-day values.
+    constexpr Time getTime() const {
+        const int seconds = hasTime() ? static_cast<int>(value & TIME_MASK) - 1 : 0;
+        return Time(seconds / 3600, seconds / 60 % 60, seconds % 60);
+    }
+    constexpr DateTime withDate(const Date& date) const {
+        return DateTime((std::int64_t(date.toDayNumber()) << TIME_BITS) | (value & TIME_MASK));
+    }
+    constexpr DateTime withoutTime() const { return DateTime(value & ~TIME_MASK); }
+
+    constexpr bool operator==(const DateTime& other) const { return value == other.value; }
+    constexpr bool operator!=(const DateTime& other) const { return value != other.value; }
+    constexpr bool operator<(const DateTime& other) const { return value < other.value; }
+    constexpr bool operator>(const DateTime& other) const { return value > other.value; }
+    constexpr bool operator<=(const DateTime& other) const { return value <= other.value; }
+    constexpr bool operator>=(const DateTime& other) const { return value >= other.value; }
+};
+
+template <>
+struct std::hash<DateTime> {
+    std::size_t operator()(const DateTime& dateTime) const noexcept {
+        return std::hash<std::int64_t>()(dateTime.getValue());
+    }
+};
+
+// Invalid values fall back to the current date/time, as the constructors
+// always did. Constant evaluation cannot read the clock, so a constexpr
+// Date or Time built from invalid values fails to compile.
+constexpr Date::Date(int d, int m, int y) : serial(0) {
+    if (!setDate(d, m, y)) {
+        *this = Date();
+    }
+}
+
+constexpr Date Date::fromDayNumber(int days) {
+    Date result(1, 1, 1970);
+    result.serial = days;
+    return result;
+}
+
+// Howard Hinnant's days_from_civil: counts in 400-year eras of 146097 days,
+// with years starting in March so the leap day falls at the end.
+constexpr int Date::daysFromCivil(int d, int m, int y) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+constexpr void Date::civilFromDays(int days, int& d, int& m, int& y) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = days - era * 146097;
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = yoe + era * 400 + (m <= 2);
+}
+
+constexpr int Date::getDay() const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+    return d;
+}
+
+constexpr int Date::getMonth() const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+    return m;
+}
+
+constexpr int Date::getYear() const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+    return y;
+}
+
+constexpr bool Date::isLeapYear(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+}
+
+constexpr int Date::daysInMonth(int m, int y) {
+    if (m < 1 || m > 12) return 0;
+
+    constexpr int daysPerMonth[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (m == 2 && isLeapYear(y))
+        return 29;
+    return daysPerMonth[m];
+}
+
+constexpr bool Date::isValidDate(int d, int m, int y) {
+    if (y < 1 || y > MAX_YEAR || m < 1 || m > 12 || d < 1)
+        return false;
+
+    return d <= daysInMonth(m, y);
+}
+
+constexpr bool Date::setDay(int d) {
+    int day, month, year;
+    civilFromDays(serial, day, month, year);
+    if (isValidDate(d, month, year)) {
+        serial += d - day;
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Date::setMonth(int m) {
+    if (m >= 1 && m <= 12) {
+        int day, month, year;
+        civilFromDays(serial, day, month, year);
+        int maxDay = daysInMonth(m, year);
+        if (day > maxDay) {
+            day = maxDay;
+        }
+        serial = daysFromCivil(day, m, year);
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Date::setYear(int y) {
+    if (y >= 1 && y <= MAX_YEAR) {
+        int day, month, year;
+        civilFromDays(serial, day, month, year);
+
+        if (month == 2 && day == 29 && !isLeapYear(y)) {
+            day = 28;
+        }
+        serial = daysFromCivil(day, month, y);
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Date::setDate(int d, int m, int y) {
+    if (isValidDate(d, m, y)) {
+        serial = daysFromCivil(d, m, y);
+        return true;
+    }
+    return false;
+}
+
+// 01/01/1970 was a Thursday.
+constexpr int Date::getDayOfWeekNumber() const {
+    return (serial % 7 + 11) % 7;
+}
+
+// The Gregorian calendar repeats every 400 years (146097 days, a whole
+// number of weeks), so everything that depends only on the year is
+// precomputed once per position in the cycle. The helpers below are
+// implementation details of the inline definitions in this header.
+namespace detail {
+
+struct YearCycleEntry {
+    std::uint8_t jan1Weekday;   // 0 = Sunday
+    std::uint8_t leap;
+    std::int8_t isoWeek1Start;  // zero-based day of year of the Monday of ISO week 1
+    std::uint8_t isoWeeks;      // 52 or 53
+};
+
+constexpr std::array<YearCycleEntry, 400> buildYearCycleTable() {
+    std::array<YearCycleEntry, 400> table{};
+    int jan1Weekday = 6;  // 01/01/2000, the start of a cycle, was a Saturday
+    for (int i = 0; i < 400; i++) {
+        const bool leap = Date::isLeapYear(2000 + i);
+        const int isoDay = (jan1Weekday + 6) % 7;  // 0 = Monday
+        const bool longYear = isoDay == 3 || (leap && isoDay == 2);
+
+        table[i].jan1Weekday = static_cast<std::uint8_t>(jan1Weekday);
+        table[i].leap = leap;
+        table[i].isoWeek1Start = static_cast<std::int8_t>(isoDay <= 3 ? -isoDay : 7 - isoDay);
+        table[i].isoWeeks = longYear ? 53 : 52;
+
+        jan1Weekday = (jan1Weekday + (leap ? 366 : 365)) % 7;
+    }
+    return table;
+}
+
+inline constexpr std::array<YearCycleEntry, 400> YEAR_CYCLE_TABLE = buildYearCycleTable();
+
+inline constexpr int DAYS_BEFORE_MONTH[2][13] = {
+    { 0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 },
+    { 0, 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335 }
+};
+
+} // namespace detail
+
+constexpr Date::DayInfo Date::getDayInfo() const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+
+    const detail::YearCycleEntry& entry = detail::YEAR_CYCLE_TABLE[(y % 400 + 400) % 400];
+    const int dayIndex = detail::DAYS_BEFORE_MONTH[entry.leap][m] + d - 1;
+
+    DayInfo info{};
+    info.weekday = (entry.jan1Weekday + dayIndex) % 7;
+    info.dayOfYear = dayIndex + 1;
+    info.isoWeek = (dayIndex - entry.isoWeek1Start + 7) / 7;
+    info.isoWeekYear = y;
+
+    if (info.isoWeek == 0) {
+        info.isoWeek = detail::YEAR_CYCLE_TABLE[((y - 1) % 400 + 400) % 400].isoWeeks;
+        info.isoWeekYear = y - 1;
+    }
+    else if (info.isoWeek > entry.isoWeeks) {
+        info.isoWeek = 1;
+        info.isoWeekYear = y + 1;
+    }
+    return info;
+}
+
+constexpr int Date::getDayOfYear() const {
+    return getDayInfo().dayOfYear;
+}
+
+constexpr int Date::getIsoWeek() const {
+    return getDayInfo().isoWeek;
+}
+
+constexpr int Date::getIsoWeekYear() const {
+    return getDayInfo().isoWeekYear;
+}
+
+constexpr Date Date::addMonths(int months) const {
+    int d, m, y;
+    civilFromDays(serial, d, m, y);
+
+    int monthIndex = y * 12 + (m - 1) + months;
+    y = (monthIndex >= 0 ? monthIndex : monthIndex - 11) / 12;
+    m = monthIndex - y * 12 + 1;
+
+    const int maxDay = daysInMonth(m, y);
+    return fromDayNumber(daysFromCivil(d < maxDay ? d : maxDay, m, y));
+}
+
+constexpr Date& Date::operator++() {
+    *this += 1;
+    return *this;
+}
+
+constexpr Date Date::operator++(int) {
+    Date temp(*this);
+    ++(*this);
+    return temp;
+}
+
+constexpr Date& Date::operator--() {
+    *this -= 1;
+    return *this;
+}
+
+constexpr Date Date::operator--(int) {
+    Date temp(*this);
+    --(*this);
+    return temp;
+}
+
+constexpr Date& Date::operator+=(int days) {
+    serial += days;
+    return *this;
+}
+
+constexpr Date& Date::operator-=(int days) {
+    serial -= days;
+    return *this;
+}
+
+constexpr Date Date::operator+(int days) const {
+    Date result(*this);
+    result += days;
+    return result;
+}
+
+constexpr Date Date::operator-(int days) const {
+    Date result(*this);
+    result -= days;
+    return result;
+}
+
+constexpr int Date::operator-(const Date& other) const {
+    return serial - other.serial;
+}
+
+constexpr bool Date::operator==(const Date& other) const {
+    return serial == other.serial;
+}
+
+constexpr bool Date::operator!=(const Date& other) const {
+    return !(*this == other);
+}
+
+constexpr bool Date::operator<(const Date& other) const {
+    return serial < other.serial;
+}
+
+constexpr bool Date::operator>(const Date& other) const {
+    return other < *this;
+}
+
+constexpr bool Date::operator<=(const Date& other) const {
+    return !(other < *this);
+}
+
+constexpr bool Date::operator>=(const Date& other) const {
+    return !(*this < other);
+}
+
+constexpr Time::Time(int h, int m, int s) : hour(0), minute(0), second(0) {
+    if (!setTime(h, m, s)) {
+        *this = Time();
+    }
+}
+
+constexpr bool Time::isValidTime(int h, int m, int s) {
+    return (h >= 0 && h < 24 && m >= 0 && m < 60 && s >= 0 && s < 60);
+}
+
+constexpr bool Time::setHour(int h) {
+    if (h >= 0 && h < 24) {
+        hour = h;
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Time::setMinute(int m) {
+    if (m >= 0 && m < 60) {
+        minute = m;
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Time::setSecond(int s) {
+    if (s >= 0 && s < 60) {
+        second = s;
+        return true;
+    }
+    return false;
+}
+
+constexpr bool Time::setTime(int h, int m, int s) {
+    if (isValidTime(h, m, s)) {
+        hour = h;
+        minute = m;
+        second = s;
+        return true;
+    }
+    return false;
+}
+
+constexpr Time& Time::operator++() {
+    *this += 1;
+    return *this;
+}
+
+constexpr Time Time::operator++(int) {
+    Time temp(*this);
+    ++(*this);
+    return temp;
+}
+
+constexpr Time& Time::operator--() {
+    *this -= 1;
+    return *this;
+}
+
+constexpr Time Time::operator--(int) {
+    Time temp(*this);
+    --(*this);
+    return temp;
+}
+
+constexpr Time& Time::operator+=(int seconds) {
+    if (seconds < 0) {
+        return *this -= -seconds;
+    }
+
+    int totalSeconds = hour * 3600 + minute * 60 + second + seconds;
+    totalSeconds %= (24 * 3600);
+
+    hour = totalSeconds / 3600;
+    totalSeconds %= 3600;
+    minute = totalSeconds / 60;
+    second = totalSeconds % 60;
+
+    return *this;
+}
+
+constexpr Time& Time::operator-=(int seconds) {
+    if (seconds < 0) {
+        return *this += -seconds;
+    }
+
+    int totalSeconds = (hour * 3600 + minute * 60 + second - seconds) % (24 * 3600);
+    if (totalSeconds < 0) {
+        totalSeconds += 24 * 3600;
+    }
+
+    hour = totalSeconds / 3600;
+    totalSeconds %= 3600;
+    minute = totalSeconds / 60;
+    second = totalSeconds % 60;
+
+    return *this;
+}
+
+constexpr Time Time::operator+(int seconds) const {
+    Time result(*this);
+    result += seconds;
+    return result;
+}
+
+constexpr Time Time::operator-(int seconds) const {
+    Time result(*this);
+    result -= seconds;
+    return result;
+}
+
+constexpr int Time::operator-(const Time& other) const {
+    int thisTotalSeconds = hour * 3600 + minute * 60 + second;
+    int otherTotalSeconds = other.hour * 3600 + other.minute * 60 + other.second;
+
+    return thisTotalSeconds - otherTotalSeconds;
+}
+
+constexpr bool Time::operator==(const Time& other) const {
+    return (hour == other.hour && minute == other.minute && second == other.second);
+}
+
+constexpr bool Time::operator!=(const Time& other) const {
+    return !(*this == other);
+}
+
+constexpr bool Time::operator<(const Time& other) const {
+    if (hour != other.hour) return hour < other.hour;
+    if (minute != other.minute) return minute < other.minute;
+    return second < other.second;
+}
+
+constexpr bool Time::operator>(const Time& other) const {
+    return other < *this;
+}
+
+constexpr bool Time::operator<=(const Time& other) const {
+    return !(other < *this);
+}
+
+constexpr bool Time::operator>=(const Time& other) const {
+    return !(*this < other);
+}
+
+namespace detail {
+
+// Reads up to maxDigits decimal digits; false if there are none.
+constexpr bool parseNumberField(const char*& it, const char* end, int maxDigits, int& value) {
+    value = 0;
+    int digits = 0;
+    while (it != end && *it >= '0' && *it <= '9' && digits < maxDigits) {
+        value = value * 10 + (*it - '0');
+        ++it;
+        ++digits;
+    }
+    return digits > 0;
+}
+
+constexpr bool parseSeparator(const char*& it, const char* end, char separator) {
+    if (it == end || *it != separator) {
+        return false;
+    }
+    ++it;
+    return true;
+}
+
+} // namespace detail
+
+// Accepts "D/M/Y" with 1-2 digit day and month and a 1-4 digit year.
+// result is left untouched on error.
+constexpr ParseError Date::parse(std::string_view text, Date& result) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    int d = 0, m = 0, y = 0;
+
+    if (!detail::parseNumberField(it, end, 2, d) || !detail::parseSeparator(it, end, '/') ||
+        !detail::parseNumberField(it, end, 2, m) || !detail::parseSeparator(it, end, '/') ||
+        !detail::parseNumberField(it, end, 4, y) || it != end) {
+        return ParseError::InvalidFormat;
+    }
+    if (!isValidDate(d, m, y)) {
+        return ParseError::InvalidValue;
+    }
+    result.serial = daysFromCivil(d, m, y);
+    return ParseError::None;
+}
+
+constexpr ParseError Time::parse(std::string_view text, Time& result) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    int h = 0, m = 0, s = 0;
+
+    if (!detail::parseNumberField(it, end, 2, h) || !detail::parseSeparator(it, end, ':') ||
+        !detail::parseNumberField(it, end, 2, m) || !detail::parseSeparator(it, end, ':') ||
+        !detail::parseNumberField(it, end, 2, s) || it != end) {
+        return ParseError::InvalidFormat;
+    }
+    if (!isValidTime(h, m, s)) {
+        return ParseError::InvalidValue;
+    }
+    result.hour = h;
+    result.minute = m;
+    result.second = s;
+    return ParseError::None;
+}
+
+// Compile-time literals: "25/12/2025"_date and "14:30:00"_time. A malformed
+// or out-of-range literal is not a constant expression and fails to compile.
+consteval Date operator""_date(const char* text, std::size_t length) {
+    Date result(1, 1, 1970);
+    if (Date::parse(std::string_view(text, length), result) != ParseError::None) {
+        throw "invalid date literal";
+    }
+    return result;
+}
+
+consteval Time operator""_time(const char* text, std::size_t length) {
+    Time result(0, 0, 0);
+    if (Time::parse(std::string_view(text, length), result) != ParseError::None) {
+        throw "invalid time literal";
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#include "daysummary.h"
+
+void DaySummaryCache::add(const Date& date, std::uint8_t priority, bool timed) {
+    DaySummary& summary = days[date.toDayNumber()];
+    summary.count++;
+    summary.priorityCounts[priority]++;
+    if (timed) {
+        summary.timedCount++;
+    }
+}
+
+void DaySummaryCache::remove(const Date& date, std::uint8_t priority, bool timed) {
+    auto it = days.find(date.toDayNumber());
+    if (it == days.end()) {
+        return;
+    }
+    if (it->second.count == 1) {
+        days.erase(it);
+        return;
+    }
+    DaySummary& summary = it->second;
+    summary.count--;
+    summary.priorityCounts[priority]--;
+    if (timed) {
+        summary.timedCount--;
+    }
+}
+
+const DaySummary& DaySummaryCache::get(const Date& date) const {
+    static const DaySummary none;
+    auto it = days.find(date.toDayNumber());
+    return it == days.end() ? none : it->second;
+}
+
+std::size_t DaySummaryCache::memoryUsage() const {
+    const std::size_t nodeBytes = sizeof(std::pair<const int, DaySummary>) + 2 * sizeof(void*);
+    return days.bucket_count() * sizeof(void*) + days.size() * nodeBytes;
+}
@@ -0,0 +1,58 @@
+#ifndef DAYSUMMARY_H
+#define DAYSUMMARY_H
+
+#include "datetime.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// What the month grid needs to know about one day's events. Priorities are
+// the underlying values of EventPriority, as in EventColumns.
+struct DaySummary {
+    std::uint32_t count = 0;
+    std::uint32_t timedCount = 0;
+    std::uint32_t priorityCounts[4] = {};
+
+    bool hasEvents() const { return count != 0; }
+    bool hasTimed() const { return timedCount != 0; }
+    // Highest priority value present, or -1 for a day without events.
+    int maxPriority() const {
+        for (int priority = 3; priority >= 0; priority--) {
+            if (priorityCounts[priority] != 0) {
+                return priority;
+            }
+        }
+        return -1;
+    }
+
+    // Folds in the summary of more events on the same day.
+    DaySummary& merge(const DaySummary& other) {
+        count += other.count;
+        timedCount += other.timedCount;
+        for (int priority = 0; priority < 4; priority++) {
+            priorityCounts[priority] += other.priorityCounts[priority];
+        }
+        return *this;
+    }
+};
+
+// Per-day summaries keyed by day number, updated one event at a time. Only the
+// day an event lands on changes, and a day whose last event goes is dropped,
+// so days without events cost nothing.
+class DaySummaryCache {
+private:
+    std::unordered_map<int, DaySummary> days;
+
+public:
+    void add(const Date& date, std::uint8_t priority, bool timed);
+    void remove(const Date& date, std::uint8_t priority, bool timed);
+    void clear() { days.clear(); }
+    void reserve(std::size_t dayCount) { days.reserve(dayCount); }
+
+    // An empty summary for days without events.
+    const DaySummary& get(const Date& date) const;
+    // Approximate, counting one hash node per day.
+    std::size_t memoryUsage() const;
+};
+
+#endif
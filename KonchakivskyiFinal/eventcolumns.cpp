@@ -0,0 +1,413 @@
+#include "eventcolumns.h"
+#include "datebatch.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define EVENTCOLUMNS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EVENTCOLUMNS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define EVENTCOLUMNS_TARGET(isa)
+#endif
+
+static constexpr std::size_t NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+// Every kernel reports the matching rows of [from, to) in order, stopping
+// after limit of them. With out == nullptr it only counts.
+using ScanKernel = std::size_t (*)(const std::uint8_t* types, const std::uint8_t* priorities,
+    std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::size_t limit);
+
+static std::size_t scanScalar(const std::uint8_t* types, const std::uint8_t* priorities,
+    std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::size_t limit) {
+    std::size_t found = 0;
+    for (std::size_t i = from; i < to && found < limit; i++) {
+        if (((typeMask >> types[i]) & (priorityMask >> priorities[i]) & 1) != 0) {
+            if (out != nullptr) {
+                out[found] = static_cast<std::uint32_t>(i);
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+#ifdef EVENTCOLUMNS_X86
+
+// Column values are below 16, so pshufb looks each byte up in a 16-entry
+// table holding 0xFF for accepted values. ANDing the two lookups and taking
+// movemask gives one bit per matching row; the matches are then compressed
+// out of that mask with count-trailing-zeros.
+
+static void fillLookup(std::uint16_t mask, std::uint8_t* table) {
+    for (int value = 0; value < 16; value++) {
+        table[value] = ((mask >> value) & 1) != 0 ? 0xFF : 0x00;
+    }
+}
+
+// Appends the rows of a block match mask; returns false once limit is hit.
+static bool emitMatches(std::uint32_t bits, std::size_t base, std::uint32_t* out, std::size_t limit, std::size_t& found) {
+    if (out == nullptr && limit == NO_LIMIT) {
+        found += std::popcount(bits);
+        return true;
+    }
+    while (bits != 0) {
+        if (out != nullptr) {
+            out[found] = static_cast<std::uint32_t>(base + std::countr_zero(bits));
+        }
+        if (++found == limit) {
+            return false;
+        }
+        bits &= bits - 1;
+    }
+    return true;
+}
+
+EVENTCOLUMNS_TARGET("sse4.1")
+static std::size_t scanSSE41(const std::uint8_t* types, const std::uint8_t* priorities,
+    std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::size_t limit) {
+    alignas(16) std::uint8_t typeTable[16];
+    alignas(16) std::uint8_t priorityTable[16];
+    fillLookup(typeMask, typeTable);
+    fillLookup(priorityMask, priorityTable);
+    const __m128i typeLookup = _mm_load_si128(reinterpret_cast<const __m128i*>(typeTable));
+    const __m128i priorityLookup = _mm_load_si128(reinterpret_cast<const __m128i*>(priorityTable));
+
+    std::size_t found = 0;
+    std::size_t i = from;
+    for (; i + 16 <= to; i += 16) {
+        const __m128i t = _mm_shuffle_epi8(typeLookup, _mm_loadu_si128(reinterpret_cast<const __m128i*>(types + i)));
+        const __m128i p = _mm_shuffle_epi8(priorityLookup, _mm_loadu_si128(reinterpret_cast<const __m128i*>(priorities + i)));
+        const std::uint32_t bits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(t, p)));
+        if (!emitMatches(bits, i, out, limit, found)) {
+            return found;
+        }
+    }
+
+    return found + scanScalar(types, priorities, i, to, typeMask, priorityMask,
+        out != nullptr ? out + found : nullptr, limit == NO_LIMIT ? NO_LIMIT : limit - found);
+}
+
+EVENTCOLUMNS_TARGET("avx2")
+static std::size_t scanAVX2(const std::uint8_t* types, const std::uint8_t* priorities,
+    std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::size_t limit) {
+    alignas(16) std::uint8_t typeTable[16];
+    alignas(16) std::uint8_t priorityTable[16];
+    fillLookup(typeMask, typeTable);
+    fillLookup(priorityMask, priorityTable);
+    // vpshufb looks up within each 128-bit lane, so both lanes get the table.
+    const __m256i typeLookup = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(typeTable)));
+    const __m256i priorityLookup = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(priorityTable)));
+
+    std::size_t found = 0;
+    std::size_t i = from;
+    for (; i + 32 <= to; i += 32) {
+        const __m256i t = _mm256_shuffle_epi8(typeLookup, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(types + i)));
+        const __m256i p = _mm256_shuffle_epi8(priorityLookup, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(priorities + i)));
+        const std::uint32_t bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(t, p)));
+        if (!emitMatches(bits, i, out, limit, found)) {
+            return found;
+        }
+    }
+
+    return found + scanScalar(types, priorities, i, to, typeMask, priorityMask,
+        out != nullptr ? out + found : nullptr, limit == NO_LIMIT ? NO_LIMIT : limit - found);
+}
+
+#endif
+
+static ScanKernel pickKernel() {
+    switch (DateBatch::bestKernel()) {
+#ifdef EVENTCOLUMNS_X86
+    case DateBatch::Kernel::AVX2:
+        return scanAVX2;
+    case DateBatch::Kernel::SSE41:
+        return scanSSE41;
+#endif
+    default:
+        return scanScalar;
+    }
+}
+
+static std::size_t scan(const std::uint8_t* types, const std::uint8_t* priorities,
+    std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::size_t limit) {
+    static const ScanKernel kernel = pickKernel();
+    if (from >= to) {
+        return 0;
+    }
+    return kernel(types, priorities, from, to, typeMask, priorityMask, out, limit);
+}
+
+std::uint32_t EventColumns::appendTitle(std::string_view title) {
+    const std::uint32_t offset = static_cast<std::uint32_t>(titleHeap.size());
+    titleHeap.append(title);
+    return offset;
+}
+
+// Rewrites the heap in row order, dropping the titles of erased rows.
+void EventColumns::compactTitles() {
+    std::string heap;
+    heap.reserve(titleHeap.size() - deadTitleBytes);
+    for (std::size_t row = 0; row < size(); row++) {
+        const std::uint32_t offset = static_cast<std::uint32_t>(heap.size());
+        heap.append(getTitle(row));
+        titleOffsets[row] = offset;
+    }
+    titleHeap.swap(heap);
+    deadTitleBytes = 0;
+}
+
+void EventColumns::compactTitlesIfSparse() {
+    if (deadTitleBytes > 4096 && deadTitleBytes > titleHeap.size() / 2) {
+        compactTitles();
+    }
+}
+
+void EventColumns::insert(std::size_t row, std::int64_t key, std::uint8_t type, std::uint8_t priority, std::string_view title) {
+    keys.insert(keys.begin() + row, key);
+    types.insert(types.begin() + row, type);
+    priorities.insert(priorities.begin() + row, priority);
+    titleOffsets.insert(titleOffsets.begin() + row, appendTitle(title));
+    titleLengths.insert(titleLengths.begin() + row, static_cast<std::uint32_t>(title.size()));
+
+    // Appending needs no shifts: no bitmap holds a row past the end.
+    const bool appended = row + 1 == keys.size();
+    for (std::uint8_t value = 0; value < 16; value++) {
+        if (appended || (typeCounts[value] == 0 && value != type)) {
+            continue;
+        }
+        typeIndex[value].insert(row, value == type);
+    }
+    for (std::uint8_t value = 0; value < 16; value++) {
+        if (appended || (priorityCounts[value] == 0 && value != priority)) {
+            continue;
+        }
+        priorityIndex[value].insert(row, value == priority);
+    }
+    if (appended) {
+        typeIndex[type].set(row);
+        priorityIndex[priority].set(row);
+    }
+    typeCounts[type]++;
+    priorityCounts[priority]++;
+}
+
+void EventColumns::erase(std::size_t row) {
+    deadTitleBytes += titleLengths[row];
+    typeCounts[types[row]]--;
+    priorityCounts[priorities[row]]--;
+    for (std::uint8_t value = 0; value < 16; value++) {
+        if (typeCounts[value] != 0 || value == types[row]) {
+            typeIndex[value].erase(row);
+        }
+        if (priorityCounts[value] != 0 || value == priorities[row]) {
+            priorityIndex[value].erase(row);
+        }
+    }
+    keys.erase(keys.begin() + row);
+    types.erase(types.begin() + row);
+    priorities.erase(priorities.begin() + row);
+    titleOffsets.erase(titleOffsets.begin() + row);
+    titleLengths.erase(titleLengths.begin() + row);
+
+    compactTitlesIfSparse();
+}
+
+void EventColumns::update(std::size_t row, std::uint8_t type, std::uint8_t priority, std::string_view title) {
+    if (type != types[row]) {
+        typeIndex[types[row]].reset(row);
+        typeCounts[types[row]]--;
+        typeIndex[type].set(row);
+        typeCounts[type]++;
+        types[row] = type;
+    }
+    if (priority != priorities[row]) {
+        priorityIndex[priorities[row]].reset(row);
+        priorityCounts[priorities[row]]--;
+        priorityIndex[priority].set(row);
+        priorityCounts[priority]++;
+        priorities[row] = priority;
+    }
+    if (title != getTitle(row)) {
+        deadTitleBytes += titleLengths[row];
+        titleOffsets[row] = appendTitle(title);
+        titleLengths[row] = static_cast<std::uint32_t>(title.size());
+        compactTitlesIfSparse();
+    }
+}
+
+void EventColumns::kill(std::size_t row) {
+    update(row, DEAD, priorities[row], std::string_view());
+}
+
+void EventColumns::reserve(std::size_t rows) {
+    keys.reserve(rows);
+    types.reserve(rows);
+    priorities.reserve(rows);
+    titleOffsets.reserve(rows);
+    titleLengths.reserve(rows);
+}
+
+void EventColumns::clear() {
+    keys.clear();
+    types.clear();
+    priorities.clear();
+    titleOffsets.clear();
+    titleLengths.clear();
+    titleHeap.clear();
+    deadTitleBytes = 0;
+    std::fill(std::begin(typeCounts), std::end(typeCounts), 0);
+    std::fill(std::begin(priorityCounts), std::end(priorityCounts), 0);
+    for (std::uint8_t value = 0; value < 16; value++) {
+        typeIndex[value].clear();
+        priorityIndex[value].clear();
+    }
+}
+
+std::size_t EventColumns::findNext(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask) const {
+    if (typeMask == ANY && priorityMask == ANY) {
+        return from < to ? from : to;
+    }
+    std::uint32_t row = 0;
+    if (scan(types.data(), priorities.data(), from, to, typeMask, priorityMask, &row, 1) == 0) {
+        return to;
+    }
+    return row;
+}
+
+std::size_t EventColumns::select(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out) const {
+    return scan(types.data(), priorities.data(), from, to, typeMask, priorityMask, out, NO_LIMIT);
+}
+
+// ORs words [firstWord, lastWord) of the bitmaps of one column's accepted
+// values into words.
+static void loadUnion(const RowBitmap* index, const std::size_t* counts, std::uint16_t mask, std::size_t chunk,
+    std::size_t firstWord, std::size_t lastWord, std::uint64_t* words, std::uint64_t* scratch) {
+    std::fill(words + firstWord, words + lastWord, 0);
+    for (std::uint16_t bits = mask; bits != 0; bits &= bits - 1) {
+        const int value = std::countr_zero(bits);
+        if (counts[value] == 0) {
+            continue;
+        }
+        index[value].loadWords(chunk, scratch, firstWord, lastWord);
+        for (std::size_t w = firstWord; w < lastWord; w++) {
+            words[w] |= scratch[w];
+        }
+    }
+}
+
+// Sets buffers[0, CHUNK_WORDS) to the rows [from, to) of chunk (relative to
+// its base) whose type and priority pass the masks: the OR of the accepted
+// types ANDed with the OR of the accepted priorities. buffers holds three
+// chunks' worth of words; only the words covering [from, to) are written.
+void EventColumns::loadMatches(std::size_t chunk, std::size_t from, std::size_t to,
+    std::uint16_t typeMask, std::uint16_t priorityMask, std::uint64_t* buffers) const {
+    std::uint64_t* words = buffers;
+    std::uint64_t* other = buffers + RowBitmap::CHUNK_WORDS;
+    std::uint64_t* scratch = buffers + 2 * RowBitmap::CHUNK_WORDS;
+    const std::size_t firstWord = from / 64;
+    const std::size_t lastWord = (to + 63) / 64;
+
+    if (typeMask != ANY) {
+        loadUnion(typeIndex, typeCounts, typeMask, chunk, firstWord, lastWord, words, scratch);
+    }
+    else {
+        std::fill(words + firstWord, words + lastWord, ~std::uint64_t(0));
+    }
+    if (priorityMask != ANY) {
+        loadUnion(priorityIndex, priorityCounts, priorityMask, chunk, firstWord, lastWord, other, scratch);
+        for (std::size_t w = firstWord; w < lastWord; w++) {
+            words[w] &= other[w];
+        }
+    }
+
+    if (from % 64 != 0) {
+        words[firstWord] &= ~std::uint64_t(0) << (from % 64);
+    }
+    if (to % 64 != 0) {
+        words[lastWord - 1] &= (std::uint64_t(1) << (to % 64)) - 1;
+    }
+}
+
+std::size_t EventColumns::count(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask) const {
+    if (from >= to) {
+        return 0;
+    }
+    if (typeMask == ANY && priorityMask == ANY) {
+        return to - from;
+    }
+
+    // One constrained column: the accepted values are disjoint row sets, so
+    // their counts add up, mostly from cached chunk cardinalities.
+    if (typeMask == ANY || priorityMask == ANY) {
+        const bool byType = priorityMask == ANY;
+        const std::uint16_t mask = byType ? typeMask : priorityMask;
+        std::size_t total = 0;
+        for (std::uint16_t bits = mask; bits != 0; bits &= bits - 1) {
+            const int value = std::countr_zero(bits);
+            total += (byType ? typeIndex : priorityIndex)[value].count(from, to);
+        }
+        return total;
+    }
+
+    // 24 KiB on the stack rather than the heap: count() backs
+    // EventFilter::count(), which should cost a popcount and nothing more.
+    std::uint64_t scratch[SCRATCH_WORDS];
+    std::size_t total = 0;
+    for (std::size_t chunk = from / RowBitmap::CHUNK_BITS; chunk * RowBitmap::CHUNK_BITS < to; chunk++) {
+        const std::size_t base = chunk * RowBitmap::CHUNK_BITS;
+        const std::size_t low = from > base ? from - base : 0;
+        const std::size_t high = std::min(to - base, RowBitmap::CHUNK_BITS);
+        loadMatches(chunk, low, high, typeMask, priorityMask, scratch);
+        for (std::size_t w = low / 64; w < (high + 63) / 64; w++) {
+            total += std::popcount(scratch[w]);
+        }
+    }
+    return total;
+}
+
+std::size_t EventColumns::selectIndexed(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+    std::uint32_t* out, std::uint64_t* scratch) const {
+    if (typeMask == ANY && priorityMask == ANY) {
+        return select(from, to, typeMask, priorityMask, out);
+    }
+
+    std::size_t found = 0;
+    for (std::size_t chunk = from / RowBitmap::CHUNK_BITS; chunk * RowBitmap::CHUNK_BITS < to; chunk++) {
+        const std::size_t base = chunk * RowBitmap::CHUNK_BITS;
+        const std::size_t low = from > base ? from - base : 0;
+        const std::size_t high = std::min(to - base, RowBitmap::CHUNK_BITS);
+        loadMatches(chunk, low, high, typeMask, priorityMask, scratch);
+        for (std::size_t w = low / 64; w < (high + 63) / 64; w++) {
+            for (std::uint64_t bits = scratch[w]; bits != 0; bits &= bits - 1) {
+                out[found++] = static_cast<std::uint32_t>(base + w * 64 + std::countr_zero(bits));
+            }
+        }
+    }
+    return found;
+}
+
+std::size_t EventColumns::indexMemoryUsage() const {
+    std::size_t bytes = 0;
+    for (std::uint8_t value = 0; value < 16; value++) {
+        bytes += typeIndex[value].memoryUsage() + priorityIndex[value].memoryUsage();
+    }
+    return bytes;
+}
+
+std::size_t EventColumns::memoryUsage() const {
+    return keys.capacity() * sizeof(std::int64_t) + types.capacity() + priorities.capacity() +
+        (titleOffsets.capacity() + titleLengths.capacity()) * sizeof(std::uint32_t) +
+        titleHeap.capacity() + indexMemoryUsage();
+}
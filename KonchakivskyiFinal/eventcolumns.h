@@ -0,0 +1,100 @@
+#ifndef EVENTCOLUMNS_H
+#define EVENTCOLUMNS_H
+
+#include "rowbitmap.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Structure-of-arrays copy of the fields Calendar filters on. Row i mirrors
+// the i-th event of the calendar's sorted list: its packed DateTime value, one
+// byte each for type and priority, and its title in a shared string heap. A
+// filter then reads two bytes per event instead of a whole Event, and the
+// scans use SSE4.1 or AVX2 (picked once, like DateBatch) to test 16 or 32 rows
+// per step.
+//
+// Each type and priority value also has a RowBitmap of the rows holding it.
+// Counts and selective filters combine those with word-wide AND/OR instead of
+// reading the byte columns.
+//
+// Type and priority predicates are 16-bit masks: bit v set accepts value v.
+// A removed row can stay in place as a tombstone: its type becomes DEAD, so
+// any mask without that bit skips it for free. liveTypes() is the mask to use
+// when the type is not constrained.
+class EventColumns {
+private:
+    std::vector<std::int64_t> keys;
+    std::vector<std::uint8_t> types;
+    std::vector<std::uint8_t> priorities;
+    std::vector<std::uint32_t> titleOffsets;
+    std::vector<std::uint32_t> titleLengths;
+    std::string titleHeap;
+    std::size_t deadTitleBytes = 0;  // heap bytes no row points at any more
+    std::size_t typeCounts[16] = {};      // rows holding each type value
+    std::size_t priorityCounts[16] = {};  // and each priority value
+    RowBitmap typeIndex[16];
+    RowBitmap priorityIndex[16];
+
+    std::uint32_t appendTitle(std::string_view title);
+    void compactTitles();
+    void compactTitlesIfSparse();
+    void loadMatches(std::size_t chunk, std::size_t from, std::size_t to,
+        std::uint16_t typeMask, std::uint16_t priorityMask, std::uint64_t* buffers) const;
+
+public:
+    static constexpr std::uint16_t ANY = 0xFFFF;
+    static constexpr std::uint8_t DEAD = 15;
+    static constexpr std::uint16_t LIVE = ANY & ~(1u << DEAD);
+
+    std::size_t size() const { return keys.size(); }
+    bool empty() const { return keys.empty(); }
+
+    void insert(std::size_t row, std::int64_t key, std::uint8_t type, std::uint8_t priority, std::string_view title);
+    void erase(std::size_t row);
+    // Replaces a row's type, priority and title; its key stays.
+    void update(std::size_t row, std::uint8_t type, std::uint8_t priority, std::string_view title);
+    // Turns the row into a tombstone.
+    void kill(std::size_t row);
+    void reserve(std::size_t rows);
+    void clear();
+
+    const std::vector<std::int64_t>& getKeys() const { return keys; }
+    std::uint8_t getType(std::size_t row) const { return types[row]; }
+    std::uint8_t getPriority(std::size_t row) const { return priorities[row]; }
+    std::string_view getTitle(std::size_t row) const {
+        return std::string_view(titleHeap.data() + titleOffsets[row], titleLengths[row]);
+    }
+
+    // Rows in the whole store with the given type or priority value, for
+    // estimating how selective a predicate is.
+    std::size_t countOfType(std::uint8_t type) const { return typeCounts[type]; }
+    std::size_t countOfPriority(std::uint8_t priority) const { return priorityCounts[priority]; }
+    bool isDead(std::size_t row) const { return types[row] == DEAD; }
+    std::size_t deadCount() const { return typeCounts[DEAD]; }
+    // ANY while there are no tombstones, so unfiltered scans stay free.
+    std::uint16_t liveTypes() const { return typeCounts[DEAD] == 0 ? ANY : LIVE; }
+
+    // First row in [from, to) whose type and priority pass the masks, or to.
+    std::size_t findNext(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask) const;
+    // Writes the matching rows of [from, to) to out, in order, and returns how
+    // many there were. out must have room for to - from rows.
+    std::size_t select(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+        std::uint32_t* out) const;
+    // Answered from the bitmaps by popcount, in a stack scratch, so it never
+    // allocates.
+    std::size_t count(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask) const;
+    // Words of bitmap scratch the indexed paths work in.
+    static constexpr std::size_t SCRATCH_WORDS = 3 * RowBitmap::CHUNK_WORDS;
+    // Same contract as select(), evaluated over the bitmaps a chunk at a time;
+    // cheaper than the column scan when few rows match. scratch must hold
+    // SCRATCH_WORDS words; a scan keeps one for all its blocks.
+    std::size_t selectIndexed(std::size_t from, std::size_t to, std::uint16_t typeMask, std::uint16_t priorityMask,
+        std::uint32_t* out, std::uint64_t* scratch) const;
+    std::size_t indexMemoryUsage() const;
+    // Columns, title heap and indexes together.
+    std::size_t memoryUsage() const;
+};
+
+#endif
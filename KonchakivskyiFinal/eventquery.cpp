@@ -0,0 +1,388 @@
+#include "eventquery.h"
+#include <algorithm>
+#include <bit>
+#include <memory>
+
+// Rows are scanned in blocks so the candidate buffer stays in L1.
+static constexpr std::size_t BLOCK_ROWS = 1024;
+
+// Below this share of matching rows the bitmaps are mostly zero words and
+// beat reading two bytes per row.
+static constexpr double BITMAP_SELECTIVITY = 1.0 / 16;
+
+EventQuery& EventQuery::between(const Date& start, const Date& end) {
+    startDate = start;
+    endDate = end;
+    return *this;
+}
+
+EventQuery& EventQuery::from(const Date& start) {
+    startDate = start;
+    return *this;
+}
+
+EventQuery& EventQuery::until(const Date& end) {
+    endDate = end;
+    return *this;
+}
+
+EventQuery& EventQuery::inMonth(int month, int year) {
+    if (!Date::isValidDate(1, month, year)) {
+        // Matches nothing, as getEventsByMonth returns nothing.
+        startDate = Date(2, 1, 1970);
+        endDate = Date(1, 1, 1970);
+        return *this;
+    }
+    const Date firstDay(1, month, year);
+    return between(firstDay, firstDay.addMonths(1) - 1);
+}
+
+EventQuery& EventQuery::ofType(EventType type) {
+    typeMask |= static_cast<std::uint16_t>(1u << static_cast<int>(type));
+    return *this;
+}
+
+EventQuery& EventQuery::withPriority(EventPriority priority) {
+    priorityMask |= static_cast<std::uint16_t>(1u << static_cast<int>(priority));
+    return *this;
+}
+
+EventQuery& EventQuery::hasTime(bool value) {
+    timed = value;
+    return *this;
+}
+
+EventQuery& EventQuery::titleContains(const std::string& fragment) {
+    titleFragment = fragment;
+    return *this;
+}
+
+EventQuery& EventQuery::orderBy(Order order) {
+    this->order = order;
+    return *this;
+}
+
+EventQuery& EventQuery::offset(std::size_t count) {
+    skip = count;
+    return *this;
+}
+
+EventQuery& EventQuery::limit(std::size_t count) {
+    maxRows = count;
+    return *this;
+}
+
+// Share of the store whose value passes mask, from the per-value counts.
+template <typename CountOf>
+static double selectivity(std::uint16_t mask, std::size_t total, CountOf countOf) {
+    if (mask == EventColumns::ANY || total == 0) {
+        return 1.0;
+    }
+    std::size_t matching = 0;
+    for (std::uint16_t bits = mask; bits != 0; bits &= bits - 1) {
+        matching += countOf(static_cast<std::uint8_t>(std::countr_zero(bits)));
+    }
+    return static_cast<double>(matching) / static_cast<double>(total);
+}
+
+EventQuery::Plan EventQuery::plan() const {
+    const EventColumns& columns = calendar.columns;
+    Plan result;
+    // Without a type, the type column still has to skip tombstones.
+    result.typeMask = typeMask == 0 ? columns.liveTypes() : typeMask;
+    result.priorityMask = priorityMask == 0 ? EventColumns::ANY : priorityMask;
+    result.lastRow = columns.size();
+
+    // The date index is exact and costs two binary searches, so a date
+    // predicate always narrows the scan before anything else is tested.
+    if (startDate || endDate) {
+        result.useDateIndex = true;
+        const auto& keys = columns.getKeys();
+        if (startDate) {
+            result.firstRow = std::lower_bound(keys.begin(), keys.end(), DateTime(*startDate).getValue()) - keys.begin();
+        }
+        if (endDate) {
+            result.lastRow = std::lower_bound(keys.begin(), keys.end(), DateTime(*endDate + 1).getValue()) - keys.begin();
+        }
+        if (result.lastRow < result.firstRow) {
+            result.lastRow = result.firstRow;
+        }
+    }
+
+    // Type and priority are estimated from the column counts, assuming they
+    // are independent of each other and of the date.
+    const std::size_t total = columns.size();
+    const double typeShare = selectivity(result.typeMask, total,
+        [&](std::uint8_t value) { return columns.countOfType(value); });
+    const double priorityShare = selectivity(result.priorityMask, total,
+        [&](std::uint8_t value) { return columns.countOfPriority(value); });
+    result.estimatedRows = static_cast<double>(result.lastRow - result.firstRow) * typeShare * priorityShare;
+    result.useBitmaps = typeShare * priorityShare < BITMAP_SELECTIVITY;
+    result.empty = result.firstRow == result.lastRow || typeShare == 0.0 || priorityShare == 0.0 || maxRows == 0;
+    result.series = endDate && maxRows != 0 ? calendar.recurring.size() : 0;
+    return result;
+}
+
+std::string EventQuery::explain() const {
+    const Plan p = plan();
+    if (p.empty && p.series == 0) {
+        return "empty result";
+    }
+    std::string text;
+    if (p.empty) {
+        text = "no stored rows";
+    }
+    else {
+        text = p.useDateIndex ? "date index" : "full scan";
+        text += " rows [" + std::to_string(p.firstRow) + ", " + std::to_string(p.lastRow) + ")";
+        const bool byType = p.typeMask != EventColumns::ANY && p.typeMask != EventColumns::LIVE;
+        if (byType || p.priorityMask != EventColumns::ANY) {
+            text += p.useBitmaps ? " -> bitmaps on" : " -> column scan on";
+            if (byType) {
+                text += " type";
+            }
+            if (p.priorityMask != EventColumns::ANY) {
+                text += " priority";
+            }
+        }
+        else if (p.typeMask == EventColumns::LIVE) {
+            text += " -> skip removed";
+        }
+    }
+    if (p.series != 0) {
+        text += " + expand " + std::to_string(p.series) + " recurring event(s)";
+    }
+    if (timed) {
+        text += " -> has time";
+    }
+    if (!titleFragment.empty()) {
+        text += " -> title contains \"" + titleFragment + "\"";
+    }
+    if (!p.empty) {
+        text += " (about " + std::to_string(static_cast<std::size_t>(p.estimatedRows + 0.5)) + " rows)";
+    }
+    return text;
+}
+
+// Cheapest first: the time flag is a bit of the key, the title a heap search.
+bool EventQuery::matchesResiduals(std::size_t row) const {
+    const EventColumns& columns = calendar.columns;
+    if (timed && DateTime::fromValue(columns.getKeys()[row]).hasTime() != *timed) {
+        return false;
+    }
+    if (!titleFragment.empty() && columns.getTitle(row).find(titleFragment) == std::string_view::npos) {
+        return false;
+    }
+    return true;
+}
+
+// Every occurrence of a series has its type, priority, time flag and title.
+bool EventQuery::seriesMatches(const Event& first) const {
+    return (typeMask == 0 || (typeMask >> static_cast<int>(first.getType()) & 1) != 0) &&
+        (priorityMask == 0 || (priorityMask >> static_cast<int>(first.getPriority()) & 1) != 0) &&
+        (!timed || first.getHasTime() == *timed) &&
+        (titleFragment.empty() || first.getTitle().find(titleFragment) != std::string::npos);
+}
+
+// The window to expand recurring events over; false without an end date.
+bool EventQuery::seriesWindow(Date& from, Date& to) const {
+    if (!endDate || calendar.recurring.empty()) {
+        return false;
+    }
+    to = *endDate;
+    if (startDate) {
+        from = *startDate;
+    }
+    else {
+        from = calendar.recurring.front().event.getDate();
+        for (const Calendar::RecurringEvent& series : calendar.recurring) {
+            from = std::min(from, series.event.getDate());
+        }
+    }
+    return from <= to;
+}
+
+// The matching occurrences in the window, sorted; nullptr if there are none.
+std::shared_ptr<const std::vector<Event>> EventQuery::expandSeries() const {
+    Date from = Date::fromDayNumber(0);
+    Date to = from;
+    if (!seriesWindow(from, to)) {
+        return nullptr;
+    }
+    std::shared_ptr<std::vector<Event>> occurrences = calendar.expandOccurrences(from, to,
+        typeMask == 0 ? EventColumns::ANY : typeMask, priorityMask == 0 ? EventColumns::ANY : priorityMask);
+    if (occurrences && (timed || !titleFragment.empty())) {
+        std::erase_if(*occurrences, [&](const Event& event) { return !seriesMatches(event); });
+        if (occurrences->empty()) {
+            return nullptr;
+        }
+    }
+    return occurrences;
+}
+
+// Calls visit(row) for every match in plan order (or reversed) until it
+// returns false.
+template <typename Visitor>
+void EventQuery::scan(const Plan& plan, bool backwards, Visitor&& visit) const {
+    const EventColumns& columns = calendar.columns;
+    const bool filterColumns = plan.typeMask != EventColumns::ANY || plan.priorityMask != EventColumns::ANY;
+    const bool checkResiduals = timed.has_value() || !titleFragment.empty();
+    std::uint32_t candidates[BLOCK_ROWS];
+    // One bitmap scratch for every block; selectIndexed only touches the
+    // words of the block it is given.
+    std::unique_ptr<std::uint64_t[]> bitmapScratch;
+    if (filterColumns && plan.useBitmaps) {
+        bitmapScratch = std::make_unique_for_overwrite<std::uint64_t[]>(EventColumns::SCRATCH_WORDS);
+    }
+
+    const std::size_t blocks = (plan.lastRow - plan.firstRow + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    for (std::size_t b = 0; b < blocks; b++) {
+        const std::size_t block = backwards ? blocks - 1 - b : b;
+        const std::size_t from = plan.firstRow + block * BLOCK_ROWS;
+        const std::size_t to = std::min(from + BLOCK_ROWS, plan.lastRow);
+
+        std::size_t found;
+        if (filterColumns && plan.useBitmaps) {
+            found = columns.selectIndexed(from, to, plan.typeMask, plan.priorityMask, candidates, bitmapScratch.get());
+        }
+        else if (filterColumns) {
+            found = columns.select(from, to, plan.typeMask, plan.priorityMask, candidates);
+        }
+        else {
+            found = to - from;
+            for (std::size_t i = 0; i < found; i++) {
+                candidates[i] = static_cast<std::uint32_t>(from + i);
+            }
+        }
+
+        for (std::size_t i = 0; i < found; i++) {
+            const std::uint32_t row = candidates[backwards ? found - 1 - i : i];
+            if (checkResiduals && !matchesResiduals(row)) {
+                continue;
+            }
+            if (!visit(row)) {
+                return;
+            }
+        }
+    }
+}
+
+EventSelection EventQuery::run() const {
+    const Event* events = calendar.events.data();
+    const Plan p = plan();
+    const std::shared_ptr<const std::vector<Event>> occurrences = p.series != 0 ? expandSeries() : nullptr;
+    std::vector<std::uint32_t> rows;
+    if (p.empty && !occurrences) {
+        return EventSelection(events, std::move(rows));
+    }
+    const std::size_t occurrenceCount = occurrences ? occurrences->size() : 0;
+
+    if (order == Order::Chronological || order == Order::ReverseChronological) {
+        // Already in order, so offset and limit end the scan early. The
+        // occurrences are merged in as the stored rows go by: stored events
+        // come first among equal dates and times, so last when reversed.
+        const bool backwards = order == Order::ReverseChronological;
+        std::size_t toSkip = skip;
+        auto take = [&](std::uint32_t row) {
+            if (toSkip > 0) {
+                toSkip--;
+                return true;
+            }
+            rows.push_back(row);
+            return rows.size() < maxRows;
+        };
+        std::size_t next = 0;
+        auto nextIndex = [&]() { return backwards ? occurrenceCount - 1 - next : next; };
+        bool more = true;
+        if (!p.empty) {
+            scan(p, backwards, [&](std::uint32_t row) {
+                while (next < occurrenceCount) {
+                    const Event& occurrence = (*occurrences)[nextIndex()];
+                    if (backwards ? occurrence < events[row] : !(occurrence < events[row])) {
+                        break;
+                    }
+                    more = take(EventSelection::OCCURRENCE | static_cast<std::uint32_t>(nextIndex()));
+                    next++;
+                    if (!more) {
+                        return false;
+                    }
+                }
+                return more = take(row);
+            });
+        }
+        for (; more && next < occurrenceCount; next++) {
+            more = take(EventSelection::OCCURRENCE | static_cast<std::uint32_t>(nextIndex()));
+        }
+        return EventSelection(events, std::move(rows), occurrences);
+    }
+
+    if (!p.empty) {
+        scan(p, false, [&](std::uint32_t row) {
+            rows.push_back(row);
+            return true;
+        });
+    }
+    for (std::size_t i = 0; i < occurrenceCount; i++) {
+        rows.push_back(EventSelection::OCCURRENCE | static_cast<std::uint32_t>(i));
+    }
+
+    // Ties break chronologically, with stored events before occurrences at
+    // the same date and time, as in the chronological order.
+    const EventColumns& columns = calendar.columns;
+    auto occurrence = [&](std::uint32_t row) -> const Event& { return (*occurrences)[row & ~EventSelection::OCCURRENCE]; };
+    auto priorityOf = [&](std::uint32_t row) {
+        return (row & EventSelection::OCCURRENCE) != 0 ? static_cast<int>(occurrence(row).getPriority()) : columns.getPriority(row);
+    };
+    auto titleOf = [&](std::uint32_t row) {
+        return (row & EventSelection::OCCURRENCE) != 0 ? std::string_view(occurrence(row).getTitle()) : columns.getTitle(row);
+    };
+    auto keyOf = [&](std::uint32_t row) {
+        return (row & EventSelection::OCCURRENCE) != 0 ? occurrence(row).getDateTime().getValue() : columns.getKeys()[row];
+    };
+    auto before = [&](std::uint32_t a, std::uint32_t b) {
+        if (order == Order::Priority) {
+            if (priorityOf(a) != priorityOf(b)) {
+                return priorityOf(a) > priorityOf(b);
+            }
+        }
+        else if (const int c = titleOf(a).compare(titleOf(b)); c != 0) {
+            return c < 0;
+        }
+        if (occurrenceCount != 0 && keyOf(a) != keyOf(b)) {
+            return keyOf(a) < keyOf(b);
+        }
+        return a < b;  // stored rows are chronological and below the flag
+    };
+    const std::size_t wanted = maxRows > rows.size() - std::min(skip, rows.size())
+        ? rows.size() : skip + maxRows;
+    std::partial_sort(rows.begin(), rows.begin() + wanted, rows.end(), before);
+    rows.resize(wanted);
+    rows.erase(rows.begin(), rows.begin() + std::min(skip, rows.size()));
+    return EventSelection(events, std::move(rows), occurrences);
+}
+
+std::size_t EventQuery::count() const {
+    const Plan p = plan();
+    std::size_t matches = 0;
+    if (!p.empty && !timed && titleFragment.empty()) {
+        matches = calendar.columns.count(p.firstRow, p.lastRow, p.typeMask, p.priorityMask);
+    }
+    else if (!p.empty) {
+        // Ordering does not change how many rows there are.
+        const std::size_t wanted = maxRows > std::numeric_limits<std::size_t>::max() - skip
+            ? std::numeric_limits<std::size_t>::max() : skip + maxRows;
+        scan(p, false, [&](std::uint32_t) { return ++matches < wanted; });
+    }
+
+    Date from = Date::fromDayNumber(0);
+    Date to = from;
+    if (p.series != 0 && seriesWindow(from, to)) {
+        for (const Calendar::RecurringEvent& series : calendar.recurring) {
+            if (seriesMatches(series.event)) {
+                matches += series.rule.occurrencesBetween(series.event.getDate(), from, to).size();
+            }
+        }
+    }
+    matches -= std::min(skip, matches);
+    return std::min(matches, maxRows);
+}
@@ -0,0 +1,159 @@
+#ifndef EVENTQUERY_H
+#define EVENTQUERY_H
+
+#include "calendar.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The events a query selected, in the requested order. Only their row
+// numbers are stored; like the other Calendar views it refers to the
+// calendar's storage and is invalidated when events change.
+//
+// Occurrences of recurring events are copies in a vector the selection (and
+// its copies) shares; their rows are OCCURRENCE | index into it. As with
+// EventFilter, an iterator must not outlive every copy of its selection.
+class EventSelection {
+public:
+    static constexpr std::uint32_t OCCURRENCE = std::uint32_t(1) << 31;
+
+    class iterator {
+    private:
+        const Event* events = nullptr;
+        const Event* occurrences = nullptr;
+        const std::uint32_t* row = nullptr;
+
+        const Event* get() const {
+            return (*row & OCCURRENCE) != 0 ? occurrences + (*row & ~OCCURRENCE) : events + *row;
+        }
+
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Event;
+        using difference_type = std::ptrdiff_t;
+        using reference = const Event&;
+        using pointer = const Event*;
+
+        iterator() = default;
+        iterator(const Event* events, const Event* occurrences, const std::uint32_t* row)
+            : events(events), occurrences(occurrences), row(row) {}
+
+        const Event& operator*() const { return *get(); }
+        const Event* operator->() const { return get(); }
+        iterator& operator++() { ++row; return *this; }
+        iterator operator++(int) { iterator temp(*this); ++row; return temp; }
+        bool operator==(const iterator& other) const { return row == other.row; }
+    };
+
+private:
+    const Event* events = nullptr;
+    std::vector<std::uint32_t> rows;
+    std::shared_ptr<const std::vector<Event>> occurrences;
+
+    const Event* occurrenceData() const { return occurrences ? occurrences->data() : nullptr; }
+
+public:
+    EventSelection() = default;
+    EventSelection(const Event* events, std::vector<std::uint32_t> rows,
+        std::shared_ptr<const std::vector<Event>> occurrences = nullptr)
+        : events(events), rows(std::move(rows)), occurrences(std::move(occurrences)) {}
+
+    iterator begin() const { return iterator(events, occurrenceData(), rows.data()); }
+    iterator end() const { return iterator(events, occurrenceData(), rows.data() + rows.size()); }
+    std::size_t size() const { return rows.size(); }
+    bool empty() const { return rows.empty(); }
+    const Event& operator[](std::size_t i) const { return *iterator(events, occurrenceData(), rows.data() + i); }
+};
+
+// Builds a query over a Calendar from any mix of predicates, e.g.
+//
+//     calendar.query().inMonth(3, 2025).ofType(EventType::MEETING)
+//         .withPriority(EventPriority::HIGH).limit(10).run();
+//
+// Calling ofType or withPriority more than once accepts any of the given
+// values. run() plans the query first: the date index narrows the rows to
+// scan, then type and priority are tested either by the vectorised column
+// kernels or, when they are selective, by ANDing their bitmap indexes. The
+// remaining predicates are checked on each candidate in the same pass. Only
+// the final row numbers are materialised.
+//
+// A query with an end date also expands the recurring events over its
+// window, from their own first occurrence if it has no start date, and
+// merges the occurrences that pass every predicate in by date and time, after
+// the stored events of the same date and time. Without an end date there is
+// no window to expand a series in, so only stored events are listed.
+class EventQuery {
+public:
+    enum class Order {
+        Chronological,
+        ReverseChronological,
+        Priority,           // highest first, then chronological
+        Title               // by title, then chronological
+    };
+
+    // How run() will evaluate the query; see explain().
+    struct Plan {
+        std::size_t firstRow = 0;
+        std::size_t lastRow = 0;        // rows [firstRow, lastRow) are candidates
+        std::uint16_t typeMask = EventColumns::ANY;
+        std::uint16_t priorityMask = EventColumns::ANY;
+        bool useDateIndex = false;
+        bool useBitmaps = false;        // else the column scan
+        bool empty = false;             // no stored row can match
+        double estimatedRows = 0;
+        std::size_t series = 0;         // recurring events expanded over the window
+    };
+
+private:
+    const Calendar& calendar;
+    std::optional<Date> startDate;
+    std::optional<Date> endDate;
+    std::uint16_t typeMask = 0;         // 0 = not constrained
+    std::uint16_t priorityMask = 0;
+    std::optional<bool> timed;
+    std::string titleFragment;
+    Order order = Order::Chronological;
+    std::size_t skip = 0;
+    std::size_t maxRows = std::numeric_limits<std::size_t>::max();
+
+    bool matchesResiduals(std::size_t row) const;
+    bool seriesMatches(const Event& first) const;
+    bool seriesWindow(Date& from, Date& to) const;
+    std::shared_ptr<const std::vector<Event>> expandSeries() const;
+    template <typename Visitor>
+    void scan(const Plan& plan, bool backwards, Visitor&& visit) const;
+
+public:
+    explicit EventQuery(const Calendar& calendar) : calendar(calendar) {}
+
+    // Inclusive on both ends, like Calendar::getEventsByDateRange.
+    EventQuery& between(const Date& start, const Date& end);
+    EventQuery& from(const Date& start);
+    EventQuery& until(const Date& end);
+    EventQuery& inMonth(int month, int year);
+    EventQuery& ofType(EventType type);
+    EventQuery& withPriority(EventPriority priority);
+    EventQuery& hasTime(bool value = true);
+    // Case-sensitive substring of the title.
+    EventQuery& titleContains(const std::string& fragment);
+    EventQuery& orderBy(Order order);
+    EventQuery& offset(std::size_t count);
+    EventQuery& limit(std::size_t count);
+
+    Plan plan() const;
+    std::string explain() const;
+
+    EventSelection run() const;
+    // Number of matches after offset and limit. Without has-time or title
+    // predicates the stored events are a popcount over the bitmap indexes,
+    // and occurrences are counted without being built.
+    std::size_t count() const;
+};
+
+#endif
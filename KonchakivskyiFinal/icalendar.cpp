@@ -0,0 +1,692 @@
+#include "icalendar.h"
+#include "timezone.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <utility>
+
+// One unfolded content line: NAME;PARAM=...:VALUE. Only the parameters the
+// reader uses are kept.
+struct ContentLine {
+    std::string_view name;
+    std::string_view value;
+    std::string_view tzid;
+};
+
+static bool equalsIgnoreCase(std::string_view text, std::string_view upper) {
+    if (text.size() != upper.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+        if (c != upper[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parseContentLine(std::string_view line, ContentLine& result) {
+    std::size_t at = line.find_first_of(";:");
+    if (at == std::string_view::npos || at == 0) {
+        return false;
+    }
+    result.name = line.substr(0, at);
+    result.tzid = std::string_view();
+    while (line[at] == ';') {
+        const std::size_t nameStart = at + 1;
+        const std::size_t equals = line.find('=', nameStart);
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        std::size_t valueStart = equals + 1;
+        std::size_t valueEnd;
+        if (valueStart < line.size() && line[valueStart] == '"') {
+            valueStart++;
+            valueEnd = line.find('"', valueStart);
+            if (valueEnd == std::string_view::npos) {
+                return false;
+            }
+            at = valueEnd + 1;
+        }
+        else {
+            valueEnd = line.find_first_of(";:", valueStart);
+            if (valueEnd == std::string_view::npos) {
+                return false;
+            }
+            at = valueEnd;
+        }
+        if (equalsIgnoreCase(line.substr(nameStart, equals - nameStart), "TZID")) {
+            result.tzid = line.substr(valueStart, valueEnd - valueStart);
+        }
+        if (at >= line.size()) {
+            return false;
+        }
+    }
+    if (line[at] != ':') {
+        return false;
+    }
+    result.value = line.substr(at + 1);
+    return true;
+}
+
+// TEXT values escape backslash, semicolon, comma and newline.
+static void unescapeText(std::string_view value, std::string& out) {
+    out.clear();
+    for (std::size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            const char next = value[++i];
+            out.push_back(next == 'n' || next == 'N' ? '\n' : next);
+        }
+        else {
+            out.push_back(value[i]);
+        }
+    }
+}
+
+static bool parseDigits(std::string_view text, std::size_t at, std::size_t count, int& result) {
+    if (at + count > text.size()) {
+        return false;
+    }
+    result = 0;
+    for (std::size_t i = at; i < at + count; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        result = result * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+static EventPriority priorityFromLevel(std::string_view value) {
+    int level = 0;
+    if (value.empty() || !parseDigits(value, 0, value.size(), level) || level == 0) {
+        return EventPriority::MEDIUM;
+    }
+    if (level <= 4) {
+        return EventPriority::HIGH;
+    }
+    return level == 5 ? EventPriority::MEDIUM : EventPriority::LOW;
+}
+
+static bool typeFromCategories(std::string_view value, EventType& type) {
+    static const std::pair<std::string_view, EventType> names[] = {
+        { "MEETING", EventType::MEETING }, { "BIRTHDAY", EventType::BIRTHDAY }, { "HOLIDAY", EventType::HOLIDAY }
+    };
+    std::size_t start = 0;
+    while (start <= value.size()) {
+        std::size_t end = start;
+        while (end < value.size() && value[end] != ',') {
+            end += value[end] == '\\' ? 2 : 1;
+        }
+        end = std::min(end, value.size());
+        std::string_view category = value.substr(start, end - start);
+        while (!category.empty() && category.front() == ' ') {
+            category.remove_prefix(1);
+        }
+        while (!category.empty() && category.back() == ' ') {
+            category.remove_suffix(1);
+        }
+        for (const auto& [name, candidate] : names) {
+            if (equalsIgnoreCase(category, name)) {
+                type = candidate;
+                return true;
+            }
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+ICalendarReader::ICalendarReader(const std::string& path)
+    : file(std::fopen(path.c_str(), "rb")), buffer(new char[BUFFER_SIZE]) {
+    if (file == nullptr) {
+        throw std::runtime_error("Unable to open file: " + path);
+    }
+}
+
+ICalendarReader::~ICalendarReader() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+bool ICalendarReader::readPhysicalLine(std::string& out) {
+    out.clear();
+    for (;;) {
+        if (position == filled) {
+            if (atEnd) {
+                return !out.empty();
+            }
+            filled = std::fread(buffer.get(), 1, BUFFER_SIZE, file);
+            position = 0;
+            if (filled < BUFFER_SIZE) {
+                atEnd = true;
+            }
+            if (filled == 0) {
+                return !out.empty();
+            }
+        }
+        const char* start = buffer.get() + position;
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', filled - position));
+        if (newline == nullptr) {
+            out.append(start, filled - position);
+            position = filled;
+            continue;
+        }
+        out.append(start, static_cast<std::size_t>(newline - start));
+        position += static_cast<std::size_t>(newline - start) + 1;
+        if (!out.empty() && out.back() == '\r') {
+            out.pop_back();
+        }
+        return true;
+    }
+}
+
+// A line starting with a space or tab continues the one before it.
+bool ICalendarReader::readLogicalLine() {
+    if (!hasNextLine && !readPhysicalLine(nextLine)) {
+        return false;
+    }
+    line.swap(nextLine);
+    hasNextLine = false;
+    while (readPhysicalLine(nextLine)) {
+        if (nextLine.empty() || (nextLine[0] != ' ' && nextLine[0] != '\t')) {
+            hasNextLine = true;
+            break;
+        }
+        line.append(nextLine, 1);
+    }
+    return true;
+}
+
+bool ICalendarReader::parseDateTime(std::string_view value, std::string_view tzid, DateTime& result) {
+    int year, month, day;
+    if (!parseDigits(value, 0, 4, year) || !parseDigits(value, 4, 2, month) || !parseDigits(value, 6, 2, day) ||
+        !Date::isValidDate(day, month, year)) {
+        return false;
+    }
+    const Date date(day, month, year);
+    if (value.size() == 8) {
+        result = DateTime(date);
+        return true;
+    }
+    int hour, minute, second;
+    if (value[8] != 'T' || !parseDigits(value, 9, 2, hour) || !parseDigits(value, 11, 2, minute) ||
+        !parseDigits(value, 13, 2, second) || !Time::isValidTime(hour, minute, second)) {
+        return false;
+    }
+    result = DateTime(date, Time(hour, minute, second));
+
+    const bool utc = value.size() == 16 && value[15] == 'Z';
+    if (!utc && value.size() != 15) {
+        return false;
+    }
+    const TimeZone* zone = utc ? &TimeZone::utc() : nullptr;
+    if (!utc && !tzid.empty()) {
+        if (tzid != zoneName) {
+            zoneName.assign(tzid);
+            try {
+                cachedZone = &TimeZone::get(zoneName.front() == '/' ? zoneName.substr(1) : zoneName);
+            }
+            catch (const std::runtime_error&) {
+                cachedZone = nullptr;  // unknown zones are read as floating times
+            }
+        }
+        zone = cachedZone;
+    }
+    if (zone != nullptr) {
+        result = TimeZone::convert(result, *zone, TimeZone::local());
+    }
+    return true;
+}
+
+// RRULE BYDAY names, indexed by Date::getDayOfWeekNumber().
+static const char* const WEEKDAY_NAMES[] = { "SU", "MO", "TU", "WE", "TH", "FR", "SA" };
+
+// FREQ, INTERVAL, COUNT, UNTIL, BYDAY without ordinals and WKST=MO are what
+// RecurrenceRule can express; any other part makes the rule unsupported.
+bool ICalendarReader::parseRule(std::string_view value) {
+    static const std::pair<std::string_view, RecurrenceRule::Frequency> frequencies[] = {
+        { "DAILY", RecurrenceRule::Frequency::DAILY }, { "WEEKLY", RecurrenceRule::Frequency::WEEKLY },
+        { "MONTHLY", RecurrenceRule::Frequency::MONTHLY }, { "YEARLY", RecurrenceRule::Frequency::YEARLY }
+    };
+    std::optional<RecurrenceRule::Frequency> frequency;
+    int interval = 1;
+    int count = 0;
+    std::optional<Date> until;
+    std::uint8_t weekdays = 0;
+
+    while (!value.empty()) {
+        const std::size_t end = std::min(value.find(';'), value.size());
+        const std::string_view part = value.substr(0, end);
+        value.remove_prefix(std::min(end + 1, value.size()));
+        const std::size_t equals = part.find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        const std::string_view name = part.substr(0, equals);
+        const std::string_view text = part.substr(equals + 1);
+
+        if (equalsIgnoreCase(name, "FREQ")) {
+            for (const auto& [candidateName, candidate] : frequencies) {
+                if (equalsIgnoreCase(text, candidateName)) {
+                    frequency = candidate;
+                }
+            }
+            if (!frequency) {
+                return false;
+            }
+        }
+        else if (equalsIgnoreCase(name, "INTERVAL")) {
+            if (text.empty() || text.size() > 9 || !parseDigits(text, 0, text.size(), interval) || interval == 0) {
+                return false;
+            }
+        }
+        else if (equalsIgnoreCase(name, "COUNT")) {
+            if (text.empty() || text.size() > 9 || !parseDigits(text, 0, text.size(), count) || count == 0) {
+                return false;
+            }
+        }
+        else if (equalsIgnoreCase(name, "UNTIL")) {
+            DateTime last = DateTime(Date::fromDayNumber(0));
+            if (!parseDateTime(text, std::string_view(), last)) {
+                return false;
+            }
+            until = last.getDate();
+        }
+        else if (equalsIgnoreCase(name, "BYDAY")) {
+            for (std::size_t at = 0; at <= text.size(); at += 3) {
+                const std::string_view day = text.substr(at, 2);
+                const auto known = std::find_if(std::begin(WEEKDAY_NAMES), std::end(WEEKDAY_NAMES),
+                    [&](const char* candidate) { return equalsIgnoreCase(day, candidate); });
+                if (known == std::end(WEEKDAY_NAMES) || (at + 2 < text.size() && text[at + 2] != ',')) {
+                    return false;  // includes ordinals such as 1MO or -1FR
+                }
+                weekdays |= static_cast<std::uint8_t>(1u << (known - std::begin(WEEKDAY_NAMES)));
+            }
+        }
+        else if (!equalsIgnoreCase(name, "WKST") || !equalsIgnoreCase(text, "MO")) {
+            return false;
+        }
+    }
+    if (!frequency) {
+        return false;
+    }
+    rule.emplace(*frequency, interval);
+    rule->setCount(static_cast<std::uint32_t>(count));
+    if (until) {
+        rule->setUntil(*until);
+    }
+    for (int day = 0; day < 7; day++) {
+        if ((weekdays & (1u << day)) != 0) {
+            rule->onWeekday(day);
+        }
+    }
+    return true;
+}
+
+bool ICalendarReader::next(Event& event) {
+    bool inEvent = false;
+    int nested = 0;
+    bool hasStart = false;
+    EventType type = EventType::OTHER;
+    EventPriority priority = EventPriority::MEDIUM;
+    bool hasType = false;
+    ContentLine content;
+
+    while (readLogicalLine()) {
+        if (!parseContentLine(line, content)) {
+            continue;
+        }
+        if (equalsIgnoreCase(content.name, "BEGIN")) {
+            if (inEvent) {
+                nested++;
+            }
+            else if (equalsIgnoreCase(content.value, "VEVENT")) {
+                inEvent = true;
+                hasStart = false;
+                hasType = false;
+                type = EventType::OTHER;
+                priority = EventPriority::MEDIUM;
+                title.clear();
+                description.clear();
+                rule.reset();
+                exceptions.clear();
+                unsupported = false;
+            }
+            continue;
+        }
+        if (!inEvent) {
+            continue;
+        }
+        if (equalsIgnoreCase(content.name, "END")) {
+            if (nested > 0) {
+                nested--;
+                continue;
+            }
+            inEvent = false;
+            if (!hasStart || unsupported) {
+                skipped++;
+                continue;
+            }
+            if (rule) {
+                for (const Date& date : exceptions) {
+                    rule->except(date);
+                }
+            }
+            if (start.hasTime()) {
+                event = Event(start.getDate(), start.getTime(), title, type, priority, description);
+            }
+            else {
+                event = Event(start.getDate(), title, type, priority, description);
+            }
+            return true;
+        }
+        if (nested > 0) {
+            continue;
+        }
+
+        if (equalsIgnoreCase(content.name, "DTSTART")) {
+            hasStart = parseDateTime(content.value, content.tzid, start);
+        }
+        else if (equalsIgnoreCase(content.name, "RRULE")) {
+            unsupported = unsupported || rule.has_value() || !parseRule(content.value);
+        }
+        else if (equalsIgnoreCase(content.name, "EXDATE")) {
+            std::string_view dates = content.value;
+            while (!dates.empty()) {
+                const std::size_t end = std::min(dates.find(','), dates.size());
+                DateTime excluded = DateTime(Date::fromDayNumber(0));
+                if (parseDateTime(dates.substr(0, end), content.tzid, excluded)) {
+                    exceptions.push_back(excluded.getDate());
+                }
+                dates.remove_prefix(std::min(end + 1, dates.size()));
+            }
+        }
+        else if (equalsIgnoreCase(content.name, "RDATE")) {
+            unsupported = true;
+        }
+        else if (equalsIgnoreCase(content.name, "SUMMARY")) {
+            unescapeText(content.value, title);
+        }
+        else if (equalsIgnoreCase(content.name, "DESCRIPTION")) {
+            unescapeText(content.value, description);
+        }
+        else if (equalsIgnoreCase(content.name, "PRIORITY")) {
+            priority = priorityFromLevel(content.value);
+        }
+        else if (equalsIgnoreCase(content.name, "CATEGORIES") && !hasType) {
+            hasType = typeFromCategories(content.value, type);
+        }
+    }
+    if (inEvent) {
+        skipped++;  // cut off before END:VEVENT
+    }
+    return false;
+}
+
+static void appendDigits(std::string& text, long long value, int width) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (int i = count; i < width; i++) {
+        text.push_back('0');
+    }
+    while (count > 0) {
+        text.push_back(digits[--count]);
+    }
+}
+
+static void appendDate(std::string& text, const Date& date) {
+    appendDigits(text, date.getYear(), 4);
+    appendDigits(text, date.getMonth(), 2);
+    appendDigits(text, date.getDay(), 2);
+}
+
+static void appendDateTime(std::string& text, const DateTime& when) {
+    appendDate(text, when.getDate());
+    const Time time = when.getTime();
+    text.push_back('T');
+    appendDigits(text, time.getHour(), 2);
+    appendDigits(text, time.getMinute(), 2);
+    appendDigits(text, time.getSecond(), 2);
+}
+
+static void escapeText(std::string_view value, std::string& out) {
+    out.clear();
+    for (char c : value) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case ';': out += "\\;"; break;
+        case ',': out += "\\,"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': break;
+        default: out.push_back(c); break;
+        }
+    }
+}
+
+ICalendarWriter::ICalendarWriter(const std::string& path) : file(std::fopen(path.c_str(), "wb")) {
+    if (file == nullptr) {
+        throw std::runtime_error("Unable to create file: " + path);
+    }
+    const std::time_t now = std::time(nullptr);
+    const std::int64_t days = now / (24 * 3600);
+    const int seconds = static_cast<int>(now % (24 * 3600));
+    appendDateTime(stamp, DateTime(Date::fromDayNumber(static_cast<int>(days)),
+        Time(seconds / 3600, seconds / 60 % 60, seconds % 60)));
+    stamp.push_back('Z');
+
+    out.reserve(FLUSH_SIZE + 4096);
+    property("BEGIN", "VCALENDAR");
+    property("VERSION", "2.0");
+    property("PRODID", "-//KonchakivskyiFinal//Calendar//EN");
+}
+
+ICalendarWriter::~ICalendarWriter() {
+    if (!finished) {
+        try {
+            finish();
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+}
+
+// Lines longer than 75 octets continue on lines starting with a space.
+void ICalendarWriter::property(std::string_view name, std::string_view value) {
+    std::size_t room = 75;
+    if (name.size() + 1 + value.size() <= room) {
+        out << name << ':' << value << "\r\n";
+        return;
+    }
+    scratch.assign(name);
+    scratch.push_back(':');
+    scratch.append(value);
+    std::string_view rest = scratch;
+    while (rest.size() > room) {
+        std::size_t cut = room;
+        while (cut > 1 && (static_cast<unsigned char>(rest[cut]) & 0xC0) == 0x80) {
+            cut--;
+        }
+        out << rest.substr(0, cut) << "\r\n ";
+        rest.remove_prefix(cut);
+        room = 74;
+    }
+    out << rest << "\r\n";
+}
+
+void ICalendarWriter::flushIfFull() {
+    if (out.size() >= FLUSH_SIZE) {
+        out.writeTo(file);
+    }
+}
+
+void ICalendarWriter::beginEvent(const Event& event) {
+    static const char* const categories[] = { "MEETING", "BIRTHDAY", "HOLIDAY", "OTHER" };
+    static const char* const levels[] = { "9", "5", "1" };  // LOW, MEDIUM, HIGH
+
+    property("BEGIN", "VEVENT");
+    field.clear();
+    appendDigits(field, static_cast<long long>(written), 1);
+    field += '-';
+    field += stamp;
+    field += "@konchakivskyi-calendar";
+    property("UID", field);
+    property("DTSTAMP", stamp);
+    field.clear();
+    if (event.getHasTime()) {
+        appendDateTime(field, event.getDateTime());
+        property("DTSTART", field);
+    }
+    else {
+        appendDate(field, event.getDate());
+        property("DTSTART;VALUE=DATE", field);
+    }
+    escapeText(event.getTitle(), field);
+    property("SUMMARY", field);
+    if (!event.getDescription().empty()) {
+        escapeText(event.getDescription(), field);
+        property("DESCRIPTION", field);
+    }
+    property("PRIORITY", levels[static_cast<int>(event.getPriority())]);
+    property("CATEGORIES", categories[static_cast<int>(event.getType())]);
+}
+
+void ICalendarWriter::endEvent() {
+    property("END", "VEVENT");
+    written++;
+    flushIfFull();
+}
+
+// The RFC allows COUNT or UNTIL, not both, so a rule with both gets the one
+// that ends the series first.
+static bool countEndsFirst(const Date& first, const RecurrenceRule& rule) {
+    RecurrenceRule uncounted(rule.getFrequency(), rule.getInterval());
+    for (int day = 0; day < 7; day++) {
+        if ((rule.getWeekdays() & (1u << day)) != 0) {
+            uncounted.onWeekday(day);
+        }
+    }
+    const Date last = *rule.getUntil();
+    return uncounted.setUntil(last).occurrencesBetween(first, first, last).size() >= rule.getCount();
+}
+
+// An all-day series has DATE values, a timed one DATE-TIMEs at the time of
+// DTSTART, floating like DTSTART itself.
+static void appendRuleDate(std::string& text, const Date& date, const Event& event, bool endOfDay) {
+    if (!event.getHasTime()) {
+        appendDate(text, date);
+    }
+    else {
+        appendDateTime(text, DateTime(date, endOfDay ? Time(23, 59, 59) : event.getTime()));
+    }
+}
+
+void ICalendarWriter::write(const Event& event) {
+    beginEvent(event);
+    endEvent();
+}
+
+void ICalendarWriter::write(const Event& first, const RecurrenceRule& rule) {
+    static const char* const frequencies[] = { "DAILY", "WEEKLY", "MONTHLY", "YEARLY" };
+
+    beginEvent(first);
+    field = "FREQ=";
+    field += frequencies[static_cast<int>(rule.getFrequency())];
+    if (rule.getInterval() != 1) {
+        field += ";INTERVAL=";
+        appendDigits(field, rule.getInterval(), 1);
+    }
+    const bool hasUntil = rule.getUntil().has_value();
+    if (rule.getCount() != 0 && (!hasUntil || countEndsFirst(first.getDate(), rule))) {
+        field += ";COUNT=";
+        appendDigits(field, rule.getCount(), 1);
+    }
+    else if (hasUntil) {
+        field += ";UNTIL=";
+        appendRuleDate(field, *rule.getUntil(), first, true);
+    }
+    if (rule.getWeekdays() != 0) {
+        field += ";BYDAY=";
+        for (int day = 1; day <= 7; day++) {  // Monday first
+            if ((rule.getWeekdays() & (1u << day % 7)) != 0) {
+                field += WEEKDAY_NAMES[day % 7];
+                field += ',';
+            }
+        }
+        field.pop_back();
+    }
+    property("RRULE", field);
+
+    if (!rule.getExceptions().empty()) {
+        field.clear();
+        for (const Date& date : rule.getExceptions()) {
+            appendRuleDate(field, date, first, false);
+            field += ',';
+        }
+        field.pop_back();
+        property(first.getHasTime() ? "EXDATE" : "EXDATE;VALUE=DATE", field);
+    }
+    endEvent();
+}
+
+void ICalendarWriter::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    property("END", "VCALENDAR");
+    out.writeTo(file);
+    const bool failed = std::ferror(file) != 0;
+    if (std::fclose(file) != 0 || failed) {
+        file = nullptr;
+        throw std::runtime_error("Unable to write iCalendar file");
+    }
+    file = nullptr;
+}
+
+ICalendar::ImportResult ICalendar::importFile(Calendar& calendar, const std::string& path) {
+    ICalendarReader reader(path);
+    ImportResult result;
+    Event event(Date(), "");
+    calendar.deferSorting();
+    try {
+        while (reader.next(event)) {
+            if (reader.getRule()) {
+                calendar.addRecurringEvent(event, *reader.getRule());
+                result.recurring++;
+            }
+            else {
+                calendar.addEvent(event);
+            }
+            result.imported++;
+        }
+    }
+    catch (...) {
+        calendar.commitEvents();
+        throw;
+    }
+    calendar.commitEvents();
+    result.skipped = reader.getSkipped();
+    return result;
+}
+
+void ICalendar::exportFile(const Calendar& calendar, const std::string& path) {
+    ICalendarWriter writer(path);
+    for (const Event& event : calendar.getAllEvents()) {
+        writer.write(event);
+    }
+    for (const Calendar::RecurringEvent& series : calendar.getRecurringEvents()) {
+        writer.write(series.event, series.rule);
+    }
+    writer.finish();
+}
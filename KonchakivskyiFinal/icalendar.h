@@ -0,0 +1,132 @@
+#ifndef ICALENDAR_H
+#define ICALENDAR_H
+
+#include "calendar.h"
+#include "recurrence.h"
+#include "renderbuffer.h"
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TimeZone;
+
+// Reads the VEVENTs of an iCalendar file (RFC 5545) one at a time. The file
+// goes through a fixed-size read buffer and only the current unfolded line
+// and event are held, so memory stays bounded however large the feed is.
+//
+// DTSTART gives the date and time: a DATE value is an all-day event, a
+// DATE-TIME in UTC ("Z") or with a TZID is converted to the local zone, as
+// Calendar stores local times, and a floating DATE-TIME is taken as it is.
+// SUMMARY and DESCRIPTION become the title and description, PRIORITY 1-4 is
+// HIGH, 5 (or none) MEDIUM and 6-9 LOW, and the first of the CATEGORIES named
+// MEETING, BIRTHDAY or HOLIDAY gives the type, else OTHER. Other properties
+// and nested components such as VALARM are ignored. A VEVENT without a usable
+// DTSTART is skipped and counted.
+//
+// An RRULE made of FREQ (DAILY to YEARLY), INTERVAL, COUNT, UNTIL, BYDAY
+// without ordinals and WKST=MO becomes a RecurrenceRule, with the EXDATE
+// dates as its exceptions. A VEVENT whose RRULE uses anything else (BYMONTHDAY,
+// BYSETPOS, 1MO...), that has several RRULEs or that has an RDATE cannot be
+// repeated as the feed means, so it is skipped and counted as well.
+class ICalendarReader {
+private:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    std::FILE* file = nullptr;
+    std::unique_ptr<char[]> buffer;
+    std::size_t position = 0;
+    std::size_t filled = 0;
+    bool atEnd = false;
+    std::string line;       // logical line being unfolded
+    std::string nextLine;   // physical line read ahead to detect folding
+    bool hasNextLine = false;
+    std::size_t skipped = 0;
+    // Fields of the VEVENT being read.
+    DateTime start = DateTime(Date::fromDayNumber(0));
+    std::string title;
+    std::string description;
+    std::optional<RecurrenceRule> rule;
+    std::vector<Date> exceptions;  // EXDATE dates, applied to rule at the end
+    bool unsupported = false;      // recurrence the rule cannot express
+    // Last TZID seen, so a feed in one zone looks it up once.
+    std::string zoneName;
+    const TimeZone* cachedZone = nullptr;
+
+    bool readPhysicalLine(std::string& out);
+    bool readLogicalLine();
+    bool parseDateTime(std::string_view value, std::string_view tzid, DateTime& result);
+    bool parseRule(std::string_view value);
+
+public:
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit ICalendarReader(const std::string& path);
+    ICalendarReader(const ICalendarReader&) = delete;
+    ICalendarReader& operator=(const ICalendarReader&) = delete;
+    ~ICalendarReader();
+
+    // Stores the next event and returns true, or returns false at the end.
+    bool next(Event& event);
+    // The rule of the event next() last stored, or nothing if it does not
+    // repeat; then the event is the series' first occurrence.
+    const std::optional<RecurrenceRule>& getRule() const { return rule; }
+    std::size_t getSkipped() const { return skipped; }
+};
+
+// Writes events as an iCalendar file through a RenderBuffer that is flushed
+// in large blocks. Lines are folded at 75 octets without splitting UTF-8
+// sequences, and each event gets the UID and DTSTAMP the RFC requires.
+// A recurring event is written with an RRULE and its exceptions as EXDATE.
+class ICalendarWriter {
+private:
+    static constexpr std::size_t FLUSH_SIZE = 1 << 20;
+
+    std::FILE* file = nullptr;
+    RenderBuffer out;
+    std::string stamp;     // DTSTAMP shared by every event of the file
+    std::string field;     // value being formatted
+    std::string scratch;   // line being folded
+    std::size_t written = 0;
+    bool finished = false;
+
+    void property(std::string_view name, std::string_view value);
+    void flushIfFull();
+    void beginEvent(const Event& event);
+    void endEvent();
+
+public:
+    // Throws std::runtime_error if the file cannot be created.
+    explicit ICalendarWriter(const std::string& path);
+    ICalendarWriter(const ICalendarWriter&) = delete;
+    ICalendarWriter& operator=(const ICalendarWriter&) = delete;
+    // Calls finish() if it was not called, ignoring errors.
+    ~ICalendarWriter();
+
+    void write(const Event& event);
+    // A series starting with first.
+    void write(const Event& first, const RecurrenceRule& rule);
+    // Ends the calendar and closes the file. Throws std::runtime_error if
+    // anything could not be written.
+    void finish();
+};
+
+class ICalendar {
+public:
+    struct ImportResult {
+        std::size_t imported = 0;
+        std::size_t recurring = 0;  // of the imported events
+        std::size_t skipped = 0;
+    };
+
+    // Streams the file into calendar as one deferred batch (see
+    // Calendar::deferSorting), so the events are sorted and merged once.
+    // Recurring events are added with Calendar::addRecurringEvent.
+    static ImportResult importFile(Calendar& calendar, const std::string& path);
+    // Writes the single events, then every recurring event.
+    static void exportFile(const Calendar& calendar, const std::string& path);
+};
+
+#endif
@@ -1,11 +1,25 @@
 #include "datetime.h"
 #include "calendar.h"
+#include "eventquery.h"
 #include "screen.h"
 #include "dictionary.h"
 #include "deque.h"
+#include "businessdays.h"
+#include "daterange.h"
+#include "parallelrender.h"
+#include "compactevent.h"
+#include "snapshot.h"
+#include "icalendar.h"
+#include "csvloader.h"
+#include "datebatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <fstream>
 
 
@@ -54,6 +68,18 @@ void testDateTimeClass() {
 	std::cout << "today < tomorrow: " << (today < tomorrow) << std::endl;
 	std::cout << "today > tomorrow: " << (today > tomorrow) << std::endl;
 
+	std::cout << "\n--------------- Date ranges ---------------\n";
+
+	const DateRange october = DateRange::month(10, 2024);
+	std::cout << "Days in October 2024: " << october.size() << std::endl;
+	std::cout << "Mondays in October 2024: "
+		<< std::ranges::count_if(october, [](const Date& day) { return day.getDayOfWeekNumber() == 1; }) << std::endl;
+	std::cout << "Fortnightly from " << specificDate << ":";
+	for (const Date& day : DateRange(specificDate, specificDate.addMonths(2), DateRange::Step::Week, 2)) {
+		std::cout << ' ' << day;
+	}
+	std::cout << std::endl;
+
 	std::cout << "\n--------------- Time ---------------\n";
 
 	Time now;
@@ -174,6 +200,15 @@ void testCalendarClass() {
     std::cout << "\nEvents in the next 7 days:\n";
     calendar.displayEvents(calendar.getEventsByDateRange(today, today + 7));
 
+    std::cout << "\nHigh priority meetings this month, latest first:\n";
+    EventQuery highMeetings = calendar.query()
+        .inMonth(today.getMonth(), today.getYear())
+        .ofType(EventType::MEETING)
+        .withPriority(EventPriority::HIGH)
+        .orderBy(EventQuery::Order::ReverseChronological);
+    std::cout << "Plan: " << highMeetings.explain() << std::endl;
+    calendar.displayEvents(highMeetings.run());
+
     std::cout << "\nNext month:\n";
     calendar.nextMonth();
     calendar.displayCurrentMonth();
@@ -190,42 +225,59 @@ void testCalendarClass() {
     std::cout << "\nToday:\n";
     calendar.goToToday();
     calendar.displayCurrentMonth();
+
+    std::cout << "\nThis month in Tokyo:\n";
+    try {
+        calendar.displayMonth(today.getMonth(), today.getYear(), TimeZone::get("Asia/Tokyo"));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
 }
 
 void testSemesterCalculation() {
     std::cout << "\n=============== 4: Semester End Date Calculation ===============\n";
 
-    Date semesterStart(10, 2, 2025);
-    int semesterWeeks = 12;
+    constexpr Date semesterStart = "10/02/2025"_date;
+    constexpr int semesterWeeks = 12;
 
-    Date semesterEnd = Calendar::calculateSemesterEndDate(semesterStart, semesterWeeks);
+    constexpr Date semesterEnd = Calendar::calculateSemesterEndDate(semesterStart, semesterWeeks);
 
     std::cout << "Semester start date: " << semesterStart << std::endl;
     std::cout << "Semester duration: " << semesterWeeks << " weeks" << std::endl;
     std::cout << "Semester end date: " << semesterEnd << std::endl;
     std::cout << "Total days: " << (semesterEnd - semesterStart) << std::endl;
+
+    BusinessCalendar workingDays;
+    workingDays.addHoliday("08/03/2025"_date);
+    workingDays.addHoliday("21/04/2025"_date);
+    workingDays.addHoliday("01/05/2025"_date);
+
+    Date workingSemesterEnd = Calendar::calculateSemesterEndDate(semesterStart, semesterWeeks, workingDays);
+    std::cout << "Semester end date counting holidays: " << workingSemesterEnd << std::endl;
+    std::cout << "Working days: " << workingDays.countBusinessDays(semesterStart, workingSemesterEnd) << std::endl;
 }
 
 void displayBirthdayInfo() {
     std::cout << "\n=============== 5: Birthdays info ===============\n";
 
-    Date myBirthday(3, 7, 2006);
+    constexpr Date myBirthday = "03/07/2006"_date;
     std::cout << "\nMy Birthday:\n";
     Calendar::displayBirthdayInfo(myBirthday);
 
-    Date einsteinBirthday(14, 3, 1879);
+    constexpr Date einsteinBirthday = "14/03/1879"_date;
     std::cout << "\nAlbert Einstein's:\n";
     Calendar::displayBirthdayInfo(einsteinBirthday);
 
-    Date turingBirthday(23, 6, 1912);
+    constexpr Date turingBirthday = "23/06/1912"_date;
     std::cout << "\nAlan Turing's:\n";
     Calendar::displayBirthdayInfo(turingBirthday);
 
-    Date cristianoRonaldoBirthday(5, 2, 1985);
+    constexpr Date cristianoRonaldoBirthday = "05/02/1985"_date;
     std::cout << "\nCristiano Ronaldo's:\n";
     Calendar::displayBirthdayInfo(cristianoRonaldoBirthday);
 
-	Date steveJobsBirthday(24, 2, 1955);
+	constexpr Date steveJobsBirthday = "24/02/1955"_date;
 	std::cout << "\nSteve Jobs':\n";
 	Calendar::displayBirthdayInfo(steveJobsBirthday);
 }
@@ -401,6 +453,255 @@ void testDequeComposition() {
     std::cout << "flexibility and encapsulation while avoiding many of the pitfalls of inheritance." << std::endl;
 }
 
+void testParallelRendering() {
+    std::cout << "\n=============== 11: Parallel Year Rendering ===============\n" << std::endl;
+
+    Calendar calendar;
+    std::vector<Event> birthdays;
+    for (int year = 1900; year < 2200; year++) {
+        birthdays.emplace_back(Date(3, 7, year), "Birthday", EventType::BIRTHDAY, EventPriority::MEDIUM);
+        birthdays.emplace_back(Date(25, 12, year), "Christmas", EventType::HOLIDAY, EventPriority::LOW);
+    }
+    calendar.addEvents(birthdays);
+
+    const int firstYear = 1900;
+    const int lastYear = 2199;
+    using Clock = std::chrono::steady_clock;
+
+    RenderBuffer sequential;
+    const Clock::time_point start = Clock::now();
+    for (int year = firstYear; year <= lastYear; year++) {
+        calendar.renderYear(sequential, year);
+    }
+    const double sequentialMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "Rendering " << (lastYear - firstYear + 1) << " years: " << sequential.size() << " bytes" << std::endl;
+    std::cout << "Sequential renderYear: " << sequentialMs << " ms" << std::endl;
+
+    for (unsigned threads : { 1u, 2u, 4u, 0u }) {
+        ParallelRenderer renderer(threads);
+        RenderBuffer parallel;
+        const Clock::time_point parallelStart = Clock::now();
+        renderer.renderYears(parallel, calendar, firstYear, lastYear);
+        const double parallelMs = std::chrono::duration<double, std::milli>(Clock::now() - parallelStart).count();
+
+        std::cout << renderer.getThreadCount() << " thread(s): " << parallelMs << " ms, speedup "
+            << (sequentialMs / parallelMs) << "x, "
+            << (parallel.str() == sequential.str() ? "same output" : "OUTPUT DIFFERS") << std::endl;
+    }
+}
+
+void testCompactEvents() {
+    std::cout << "\n=============== 12: Compact Event Storage ===============\n" << std::endl;
+
+    // Raise to 10'000'000 to compare the layouts at that scale.
+    const int eventCount = 1'000'000;
+    const char* const titles[] = { "Team Meeting", "Code review with the platform group", "Lunch", "Gym" };
+    const char* const descriptions[] = { "", "Room 4.12, bring the quarterly numbers", "Weekly sync" };
+
+    Calendar calendar;
+    std::vector<Event> batch;
+    batch.reserve(eventCount);
+    for (int i = 0; i < eventCount; i++) {
+        batch.emplace_back(Date::fromDayNumber(19000 + i / 40), Time(8 + i % 10, i % 60, 0), titles[i % 4],
+            static_cast<EventType>(i % 4), static_cast<EventPriority>(i % 3), descriptions[i % 3]);
+    }
+    calendar.addEvents(batch);
+    batch = std::vector<Event>();
+
+    const CompactEventStore compact(calendar);
+    const double before = static_cast<double>(calendar.memoryUsage()) / eventCount;
+    const double after = static_cast<double>(compact.memoryUsage()) / eventCount;
+    std::cout << eventCount << " events, " << compact.distinctStrings() << " distinct strings" << std::endl;
+    std::cout << "Calendar: " << before << " bytes/event (sizeof(Event) = " << sizeof(Event) << ")" << std::endl;
+    std::cout << "CompactEventStore: " << after << " bytes/event (sizeof(CompactEvent) = "
+        << sizeof(CompactEvent) << ")" << std::endl;
+
+    const Event& first = *calendar.getAllEvents().begin();
+    const Event copy = compact.toEvent(0);
+    const bool same = copy == first && copy.getType() == first.getType() &&
+        copy.getPriority() == first.getPriority() && copy.getDescription() == first.getDescription();
+    std::cout << "First event round-trips: " << (same ? "yes" : "no") << std::endl;
+}
+
+void testSnapshot() {
+    std::cout << "\n=============== 13: Calendar Snapshots ===============\n" << std::endl;
+
+    const int eventCount = 1'000'000;
+    Calendar calendar;
+    std::vector<Event> batch;
+    batch.reserve(eventCount);
+    for (int i = 0; i < eventCount; i++) {
+        batch.emplace_back(Date::fromDayNumber(19000 + i / 40), Time(8 + i % 10, i % 60, 0), "Shift " + std::to_string(i % 7),
+            static_cast<EventType>(i % 4), static_cast<EventPriority>(i % 3));
+    }
+    calendar.addEvents(batch);
+    // Before the shifts start, so the restored series can be compared alone.
+    calendar.addRecurringEvent(Event(Date(28, 1, 2015), "Payroll", EventType::OTHER, EventPriority::HIGH),
+        RecurrenceRule(RecurrenceRule::Frequency::MONTHLY).setUntil(Date(31, 12, 2021)).except(Date(28, 12, 2018)));
+
+    using Clock = std::chrono::steady_clock;
+    const std::string path = "calendar.snapshot";
+    Clock::time_point start = Clock::now();
+    CalendarSnapshot::save(calendar, path);
+    std::cout << "Saved " << eventCount << " events in "
+        << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+
+    start = Clock::now();
+    const CalendarSnapshot snapshot = CalendarSnapshot::open(path);
+    std::cout << "Opened " << snapshot.getFileSize() << " bytes in "
+        << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+
+    const Date day = Date::fromDayNumber(19000 + eventCount / 80);
+    const std::span<const CompactEvent> onDay = snapshot.getEventsByDateRange(day, day);
+    std::cout << "Events on " << day << ": " << onDay.size() << " (calendar: "
+        << calendar.getEventsByDateRange(day, day).count() << ")" << std::endl;
+    if (!onDay.empty()) {
+        std::cout << "First: " << snapshot.toEvent(onDay.front()) << std::endl;
+    }
+    std::cout << "Meetings: " << snapshot.countOfType(EventType::MEETING) << std::endl;
+
+    Calendar restored;
+    snapshot.copyTo(restored);
+    const EventFilter payroll = restored.getEventsByDateRange(Date(1, 1, 2015), Date(31, 12, 2021));
+    const bool same = std::ranges::equal(payroll, calendar.getEventsByDateRange(Date(1, 1, 2015), Date(31, 12, 2021)), {},
+        &Event::toString, &Event::toString);
+    std::cout << snapshot.getRules().size() << " recurring event(s); payrolls after copyTo: " << payroll.count()
+        << ", same as before: " << (same ? "yes" : "NO") << std::endl;
+    std::remove(path.c_str());
+}
+
+void testICalendar() {
+    std::cout << "\n=============== 14: iCalendar Import and Export ===============\n" << std::endl;
+
+    Calendar calendar;
+    calendar.addEvent(Event(Date(15, 1, 2025), Time(9, 30, 0), "Planning, Q1", EventType::MEETING, EventPriority::HIGH,
+        "Agenda:\n- roadmap\n- hiring"));
+    calendar.addEvent(Event(Date(3, 7, 2025), "Birthday", EventType::BIRTHDAY, EventPriority::MEDIUM));
+    calendar.addEvent(Event(Date(25, 12, 2025), "Christmas", EventType::HOLIDAY, EventPriority::LOW));
+    calendar.addRecurringEvent(Event(Date(6, 1, 2025), Time(10, 0, 0), "Stand-up", EventType::MEETING),
+        RecurrenceRule(RecurrenceRule::Frequency::WEEKLY).onWeekday(1).onWeekday(3).setCount(20).setUntil(Date(31, 12, 2025))
+            .except(Date(8, 1, 2025)));
+    calendar.addRecurringEvent(Event(Date(31, 1, 2025), "Month end", EventType::OTHER, EventPriority::LOW),
+        RecurrenceRule(RecurrenceRule::Frequency::MONTHLY).setUntil(Date(31, 12, 2025)));
+
+    const std::string path = "calendar.ics";
+    ICalendar::exportFile(calendar, path);
+
+    Calendar imported;
+    const ICalendar::ImportResult result = ICalendar::importFile(imported, path);
+    std::cout << "Imported " << result.imported << " event(s), " << result.recurring << " of them recurring, skipped "
+        << result.skipped << std::endl;
+    imported.displayEvents(imported.getAllEvents());
+
+    // The series come back as rules, so 2025 lists the same occurrences.
+    const EventFilter before = calendar.getEventsByDateRange(Date(1, 1, 2025), Date(31, 12, 2025));
+    const EventFilter after = imported.getEventsByDateRange(Date(1, 1, 2025), Date(31, 12, 2025));
+    const bool same = std::ranges::equal(before, after, {}, &Event::toString, &Event::toString);
+    std::cout << "2025 after the round trip: " << after.count() << " event(s), same as before: " << (same ? "yes" : "NO")
+        << std::endl;
+    std::remove(path.c_str());
+}
+
+void testCsvLoader() {
+    std::cout << "\n=============== 15: CSV Bulk Loading ===============\n" << std::endl;
+
+    const std::string path = "events.csv";
+    {
+        std::ofstream csv(path, std::ios::binary);
+        csv << "date,time,title,type,priority,description\n"
+            << "20/01/2025,10:00:00,Sprint review,Meeting,High,\"Demo, then retro\"\n"
+            << "30/02/2025,,Impossible day,Other,Low\n"
+            << "14/02/2025,,Valentine's Day,Holiday,Low\n"
+            << "21/01/2025,25:00:00,Late call,Meeting,Medium\n"
+            << "03/07/2025,,\"Birthday\nparty\",Birthday,Medium\n";
+    }
+
+    CsvLoader loader;
+    Calendar calendar;
+    const CsvLoader::Result result = loader.load(calendar, path);
+    std::cout << "Loaded " << result.loaded << " event(s) on " << loader.getThreadCount() << " thread(s), dates checked with the "
+        << DateBatch::kernelName(DateBatch::bestKernel()) << " kernel" << std::endl;
+    for (const CsvLoader::Rejection& rejection : result.rejected) {
+        std::cout << "Rejected line " << rejection.line << ": " << rejection.reason << std::endl;
+    }
+    calendar.displayEvents(calendar.getAllEvents());
+
+    // Stray and unterminated quotes throw off the quote parity the chunk cuts
+    // are found with. Tiny chunks on several threads must still give exactly
+    // what a parse of the whole file in one piece gives.
+    {
+        std::ofstream csv(path, std::ios::binary);
+        for (int row = 0; row < 2000; row++) {
+            const std::string day = std::to_string(row % 28 + 1) + "/" + std::to_string(row % 12 + 1) + "/2025";
+            switch (row % 97) {
+            case 13: csv << day << ",,Say \"hi\",Meeting,Low\n"; break;
+            case 41: csv << day << ",,\"Unterminated,Meeting,Low\n"; break;
+            case 70: csv << day << ",,\"Runs\non\",Other,High\n"; break;
+            default: csv << day << ",09:30:00,Row " << row << ",Meeting,Medium\n"; break;
+            }
+        }
+    }
+    CsvLoader chunked(4, 64);
+    CsvLoader sequential(1, SIZE_MAX);
+    Calendar chunkedCalendar;
+    Calendar sequentialCalendar;
+    const CsvLoader::Result chunkedResult = chunked.load(chunkedCalendar, path);
+    const CsvLoader::Result sequentialResult = sequential.load(sequentialCalendar, path);
+    bool same = chunkedResult.loaded == sequentialResult.loaded &&
+        chunkedResult.rejected.size() == sequentialResult.rejected.size() &&
+        std::ranges::equal(chunkedCalendar.getAllEvents(), sequentialCalendar.getAllEvents(), {},
+            &Event::toString, &Event::toString);
+    for (std::size_t i = 0; same && i < chunkedResult.rejected.size(); i++) {
+        same = chunkedResult.rejected[i].line == sequentialResult.rejected[i].line &&
+            std::string_view(chunkedResult.rejected[i].reason) == sequentialResult.rejected[i].reason;
+    }
+    std::cout << "\nWith stray quotes: " << sequentialResult.loaded << " loaded, " << sequentialResult.rejected.size()
+        << " rejected; 64-byte chunks match the sequential parse: " << (same ? "yes" : "NO") << std::endl;
+    std::remove(path.c_str());
+}
+
+void testRecurringEvents() {
+    std::cout << "\n=============== 16: Recurring Events ===============\n" << std::endl;
+
+    Calendar calendar(Date(1, 3, 2025));
+    // Ten years of stand-ups are still one stored event.
+    RecurrenceRule standUp(RecurrenceRule::Frequency::WEEKLY);
+    standUp.onWeekday(1).onWeekday(3).onWeekday(5).setUntil(Date(31, 12, 2034)).except(Date(5, 3, 2025));
+    const EventId standUpId = calendar.addRecurringEvent(
+        Event(Date(3, 3, 2025), Time(9, 15, 0), "Stand-up", EventType::MEETING, EventPriority::LOW), standUp);
+    calendar.addRecurringEvent(Event(Date(25, 12, 2025), "Christmas", EventType::HOLIDAY, EventPriority::MEDIUM),
+        RecurrenceRule(RecurrenceRule::Frequency::YEARLY));
+    calendar.addRecurringEvent(Event(Date(31, 1, 2025), "Pay rent", EventType::OTHER, EventPriority::HIGH),
+        RecurrenceRule(RecurrenceRule::Frequency::MONTHLY).setCount(12));
+    calendar.addEvent(Event(Date(12, 3, 2025), Time(14, 0, 0), "Design review", EventType::MEETING, EventPriority::HIGH));
+
+    calendar.displayMonth(3, 2025);
+
+    std::cout << "\nDecember 2030: " << calendar.getEventsByMonth(12, 2030).count() << " event(s)" << std::endl;
+
+    // Nothing is stored in 2031, so everything this range lists is generated
+    // from the rules: the Monday, Wednesday and Friday stand-ups.
+    const EventFilter week = calendar.getEventsByDateRange(Date(6, 1, 2031), Date(12, 1, 2031));
+    std::size_t standUps = 0;
+    for (const Event& event : week) {
+        standUps += event.getTitle() == "Stand-up" ? 1 : 0;
+    }
+    std::cout << "6-12 January 2031: " << standUps << " stand-up(s) of " << week.count() << " event(s) (expected 3: "
+        << (standUps == 3 && week.count() == 3 ? "yes" : "NO") << ")" << std::endl;
+    const EventQuery meetings = calendar.query().between(Date(6, 1, 2031), Date(12, 1, 2031)).ofType(EventType::MEETING);
+    std::cout << "Same week through query(): " << meetings.count() << " meeting(s); " << meetings.explain() << std::endl;
+    std::cout << "Holidays 2025-2034: "
+        << calendar.getEventsByType(EventType::HOLIDAY, Date(1, 1, 2025), Date(31, 12, 2034)).count() << std::endl;
+    BusinessCalendar workingDays;
+    workingDays.addHolidays(calendar, Date(1, 1, 2025), Date(31, 12, 2034));
+    std::cout << "Wednesday 25/12/2030 is a business day: " << (workingDays.isBusinessDay(Date(25, 12, 2030)) ? "yes" : "no")
+        << std::endl;
+    RecurrenceRule fewer(*calendar.findRecurrence(standUpId));
+    calendar.updateRecurrence(standUpId, fewer.setCount(3));
+    std::cout << "Stand-ups after limiting to 3:" << std::endl;
+    calendar.displayEvents(calendar.getEventsByDateRange(Date(1, 3, 2025), Date(31, 3, 2025)));
+}
+
 int main() {
 	testDateTimeClass();
 	testEventClass();
@@ -411,5 +712,11 @@ int main() {
     testDictionaryClass();
     testDequeNVI();
     testDequeComposition();
+    testParallelRendering();
+    testCompactEvents();
+    testSnapshot();
+    testICalendar();
+    testCsvLoader();
+    testRecurringEvents();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only into memory, so readers can work on its bytes
+// without copying them. Unmapped when the object is destroyed; moving keeps
+// the mapping at the same address.
+class MappedFile {
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    void unmap();
+
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error if the file cannot be opened or mapped. An
+    // empty file gives an empty mapping.
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    const char* getData() const { return data; }
+    std::size_t getSize() const { return size; }
+    bool empty() const { return size == 0; }
+};
+
+#endif
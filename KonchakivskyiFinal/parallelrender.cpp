@@ -0,0 +1,54 @@
+#include "parallelrender.h"
+#include <cstddef>
+
+void ParallelRenderer::renderYears(RenderBuffer& out, const Calendar& calendar, int firstYear, int lastYear,
+    Calendar::YearLayout layout) {
+    std::vector<RenderBuffer> outputs(1);
+    render({ Job{ &calendar, firstYear, lastYear, layout } }, outputs);
+    out << outputs[0].str();
+}
+
+void ParallelRenderer::render(const std::vector<Job>& jobs, std::vector<RenderBuffer>& outputs) {
+    outputs.resize(jobs.size());
+
+    // Lay every part of every job out in one index space: task t belongs to
+    // the job whose range [firstTask[j], firstTask[j + 1]) contains it.
+    std::vector<std::size_t> firstTask(jobs.size() + 1, 0);
+    for (std::size_t j = 0; j < jobs.size(); j++) {
+        const Job& job = jobs[j];
+        const std::size_t years = job.lastYear >= job.firstYear ? static_cast<std::size_t>(job.lastYear - job.firstYear + 1) : 0;
+        firstTask[j + 1] = firstTask[j] + years * Calendar::yearPartCount(job.layout);
+    }
+
+    const Date today;
+    std::vector<RenderBuffer> parts(firstTask.back());
+    std::vector<std::size_t> jobOf(parts.size());
+    for (std::size_t j = 0; j < jobs.size(); j++) {
+        for (std::size_t task = firstTask[j]; task < firstTask[j + 1]; task++) {
+            jobOf[task] = j;
+        }
+    }
+
+    pool.parallelFor(parts.size(), [&](std::size_t task) {
+        const Job& job = jobs[jobOf[task]];
+        const std::size_t index = task - firstTask[jobOf[task]];
+        const int perYear = Calendar::yearPartCount(job.layout);
+        const int year = job.firstYear + static_cast<int>(index / perYear);
+        const int part = static_cast<int>(index % perYear);
+        if (part == 0) {
+            job.calendar->renderYearHeader(parts[task], year);
+        }
+        job.calendar->renderYearPart(parts[task], year, part, job.layout, today);
+    });
+
+    for (std::size_t j = 0; j < jobs.size(); j++) {
+        std::size_t bytes = outputs[j].size();
+        for (std::size_t task = firstTask[j]; task < firstTask[j + 1]; task++) {
+            bytes += parts[task].size();
+        }
+        outputs[j].reserve(bytes);
+        for (std::size_t task = firstTask[j]; task < firstTask[j + 1]; task++) {
+            outputs[j] << parts[task].str();
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PARALLELRENDER_H
+#define PARALLELRENDER_H
+
+#include "calendar.h"
+#include "renderbuffer.h"
+#include "threadpool.h"
+#include <vector>
+
+// Renders many years, of one calendar or several, on a thread pool. Every
+// year part (see Calendar::renderYearPart) goes to its own buffer on
+// whichever worker is free, and the buffers are joined in order afterwards,
+// so the text is exactly what Calendar::renderYear gives year by year.
+// Calendars must not be changed while a render is running.
+class ParallelRenderer {
+public:
+    // Years [firstYear, lastYear] of one calendar.
+    struct Job {
+        const Calendar* calendar = nullptr;
+        int firstYear = 0;
+        int lastYear = 0;
+        Calendar::YearLayout layout = Calendar::YearLayout::Column;
+    };
+
+private:
+    ThreadPool pool;
+
+public:
+    // threads == 0 uses every hardware thread.
+    explicit ParallelRenderer(unsigned threads = 0) : pool(threads) {}
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    void renderYears(RenderBuffer& out, const Calendar& calendar, int firstYear, int lastYear,
+        Calendar::YearLayout layout = Calendar::YearLayout::Column);
+    // Appends job i's text to outputs[i]; outputs is resized to match jobs.
+    // All jobs share the pool, so small jobs do not leave workers idle.
+    void render(const std::vector<Job>& jobs, std::vector<RenderBuffer>& outputs);
+};
+
+#endif
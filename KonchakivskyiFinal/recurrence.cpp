@@ -0,0 +1,142 @@
+#include "recurrence.h"
+#include "daterange.h"
+#include <algorithm>
+
+RecurrenceRule::RecurrenceRule(Frequency frequency, int interval)
+    : frequency(frequency), interval(std::max(interval, 1)) {
+}
+
+RecurrenceRule& RecurrenceRule::onWeekday(int weekday) {
+    if (weekday >= 0 && weekday < 7) {
+        weekdays |= static_cast<std::uint8_t>(1u << weekday);
+    }
+    return *this;
+}
+
+RecurrenceRule& RecurrenceRule::except(const Date& date) {
+    auto it = std::lower_bound(exceptions.begin(), exceptions.end(), date);
+    if (it == exceptions.end() || *it != date) {
+        exceptions.insert(it, date);
+    }
+    return *this;
+}
+
+static Date mondayOf(const Date& date) {
+    return date - (date.getDayOfWeekNumber() + 6) % 7;
+}
+
+// Months since year 0, so month arithmetic is plain integer arithmetic.
+static int monthIndex(const Date& date) {
+    return date.getYear() * 12 + date.getMonth() - 1;
+}
+
+template <typename Visit>
+void RecurrenceRule::forEachFrom(const Date& first, const Date& from, const Date& to, Visit visit) const {
+    std::uint32_t produced = 1;
+    if (first > to || (until && first > *until)) {
+        return;
+    }
+    if (first >= from && !visit(first)) {
+        return;
+    }
+
+    // Without a count nothing before the window matters, so start at the
+    // period that contains from.
+    long long period = 0;
+    if (count == 0 && from > first) {
+        switch (frequency) {
+        case Frequency::DAILY: period = (from - first) / interval; break;
+        case Frequency::WEEKLY: period = (mondayOf(from) - mondayOf(first)) / 7 / interval; break;
+        case Frequency::MONTHLY: period = (monthIndex(from) - monthIndex(first)) / interval; break;
+        case Frequency::YEARLY: period = (from.getYear() - first.getYear()) / interval; break;
+        }
+    }
+
+    const Date last = until && *until < to ? *until : to;
+    int candidates[366];  // day numbers, ascending
+    for (;; period++) {
+        const long long step = period * interval;
+        int found = 0;
+        Date periodStart = first;
+        switch (frequency) {
+        case Frequency::DAILY: {
+            periodStart = first + static_cast<int>(step);
+            if (weekdays == 0 || (weekdays & (1u << periodStart.getDayOfWeekNumber())) != 0) {
+                candidates[found++] = periodStart.toDayNumber();
+            }
+            break;
+        }
+        case Frequency::WEEKLY: {
+            periodStart = mondayOf(first) + static_cast<int>(step * 7);
+            if (weekdays == 0) {
+                candidates[found++] = first.toDayNumber() + static_cast<int>(step * 7);
+                break;
+            }
+            for (const Date day : DateRange(periodStart, periodStart + 7)) {
+                if ((weekdays & (1u << day.getDayOfWeekNumber())) != 0) {
+                    candidates[found++] = day.toDayNumber();
+                }
+            }
+            break;
+        }
+        case Frequency::MONTHLY:
+        case Frequency::YEARLY: {
+            const bool monthly = frequency == Frequency::MONTHLY;
+            const long long index = monthly ? monthIndex(first) + step : monthIndex(first) + step * 12;
+            const int year = static_cast<int>(index / 12);
+            const int month = monthly ? static_cast<int>(index % 12) + 1 : 1;
+            if (year > Date::MAX_YEAR) {
+                return;
+            }
+            periodStart = Date(1, month, year);
+            if (weekdays == 0) {
+                const int targetMonth = monthly ? month : first.getMonth();
+                if (Date::isValidDate(first.getDay(), targetMonth, year)) {
+                    candidates[found++] = Date(first.getDay(), targetMonth, year).toDayNumber();
+                }
+                break;
+            }
+            for (const Date day : monthly ? DateRange::month(month, year) : DateRange::year(year)) {
+                if ((weekdays & (1u << day.getDayOfWeekNumber())) != 0) {
+                    candidates[found++] = day.toDayNumber();
+                }
+            }
+            break;
+        }
+        }
+
+        if (periodStart > last) {
+            return;
+        }
+        for (int i = 0; i < found; i++) {
+            const Date day = Date::fromDayNumber(candidates[i]);
+            if (day <= first) {
+                continue;
+            }
+            if (day > last || (count != 0 && ++produced > count)) {
+                return;
+            }
+            if (day >= from && !visit(day)) {
+                return;
+            }
+        }
+    }
+}
+
+std::vector<Date> RecurrenceRule::occurrencesBetween(const Date& first, const Date& from, const Date& to) const {
+    std::vector<Date> result;
+    if (to < from) {
+        return result;
+    }
+    auto exception = std::lower_bound(exceptions.begin(), exceptions.end(), from);
+    forEachFrom(first, from, to, [&](const Date& day) {
+        while (exception != exceptions.end() && *exception < day) {
+            ++exception;
+        }
+        if (exception == exceptions.end() || *exception != day) {
+            result.push_back(day);
+        }
+        return true;
+    });
+    return result;
+}
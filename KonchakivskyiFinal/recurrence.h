@@ -0,0 +1,70 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include "datetime.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// When a recurring event repeats, in the spirit of an RFC 5545 RRULE: every
+// interval days, weeks, months or years, optionally only on some weekdays,
+// ending after count occurrences or on an until date, minus exception dates.
+//
+// The first occurrence is the series' own date. After it, each period of the
+// frequency gives:
+//   - DAILY:   its day, if it is one of the weekdays (or no weekdays are set);
+//   - WEEKLY:  the same weekday as the first occurrence, or each of the
+//              weekdays (weeks start on Monday);
+//   - MONTHLY: the same day of the month, skipped in months that are too
+//              short, or each of the weekdays in the month;
+//   - YEARLY:  the same day and month, skipped when it does not exist (29/02),
+//              or each of the weekdays in the year.
+// count includes exception dates, as in the RFC; they are only left out of
+// what is produced. Nothing is stored per occurrence: dates are generated on
+// demand for the window asked for.
+class RecurrenceRule {
+public:
+    enum class Frequency {
+        DAILY,
+        WEEKLY,
+        MONTHLY,
+        YEARLY
+    };
+
+private:
+    Frequency frequency;
+    int interval;
+    std::uint32_t count = 0;         // 0 for no limit
+    std::optional<Date> until;
+    std::uint8_t weekdays = 0;       // bit d set: getDayOfWeekNumber() == d
+    std::vector<Date> exceptions;    // sorted, no duplicates
+
+    // Calls visit with each occurrence date in order, from the first one on
+    // or after from until one after to, or until visit returns false.
+    template <typename Visit>
+    void forEachFrom(const Date& first, const Date& from, const Date& to, Visit visit) const;
+
+public:
+    // An interval below 1 is taken as 1.
+    explicit RecurrenceRule(Frequency frequency, int interval = 1);
+
+    RecurrenceRule& setCount(std::uint32_t occurrences) { count = occurrences; return *this; }
+    RecurrenceRule& setUntil(const Date& lastDate) { until = lastDate; return *this; }
+    // weekday as Date::getDayOfWeekNumber(), 0 = Sunday.
+    RecurrenceRule& onWeekday(int weekday);
+    RecurrenceRule& except(const Date& date);
+
+    Frequency getFrequency() const { return frequency; }
+    int getInterval() const { return interval; }
+    std::uint32_t getCount() const { return count; }
+    const std::optional<Date>& getUntil() const { return until; }
+    std::uint8_t getWeekdays() const { return weekdays; }
+    const std::vector<Date>& getExceptions() const { return exceptions; }
+
+    // The occurrence dates in [from, to] of a series whose first occurrence
+    // is on first. Without a count the series is entered at the period
+    // containing from; with one it is counted from the start.
+    std::vector<Date> occurrencesBetween(const Date& first, const Date& from, const Date& to) const;
+};
+
+#endif
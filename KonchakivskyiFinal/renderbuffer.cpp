@@ -0,0 +1,59 @@
+#include "renderbuffer.h"
+#include <charconv>
+#include <ostream>
+
+RenderBuffer& RenderBuffer::appendNumber(long long value) {
+    char buffer[24];
+    text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+    return *this;
+}
+
+RenderBuffer& RenderBuffer::appendTwoDigits(int value) {
+    if (value < 0 || value > 99) {
+        return appendNumber(value);
+    }
+    text.push_back(static_cast<char>('0' + value / 10));
+    text.push_back(static_cast<char>('0' + value % 10));
+    return *this;
+}
+
+RenderBuffer& RenderBuffer::appendDate(const Date& date) {
+    char buffer[Date::FORMAT_SIZE];
+    text.append(buffer, date.formatTo(buffer));
+    text += " (";
+    text += date.getDayOfWeek();
+    text += ')';
+    return *this;
+}
+
+RenderBuffer& RenderBuffer::appendTime(const Time& time) {
+    char buffer[Time::FORMAT_SIZE];
+    text.append(buffer, time.formatTo(buffer));
+    return *this;
+}
+
+RenderBuffer& RenderBuffer::beginColor(Color color) {
+    switch (color) {
+    case Color::Green: text += "\033[1;32m"; break;
+    case Color::Red: text += "\033[1;31m"; break;
+    case Color::Blue: text += "\033[1;34m"; break;
+    }
+    return *this;
+}
+
+RenderBuffer& RenderBuffer::endColor() {
+    text += "\033[0m";
+    return *this;
+}
+
+void RenderBuffer::writeTo(std::FILE* file) {
+    std::fwrite(text.data(), 1, text.size(), file);
+    std::fflush(file);
+    text.clear();
+}
+
+void RenderBuffer::writeTo(std::ostream& os) {
+    os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    os.flush();
+    text.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef RENDERBUFFER_H
+#define RENDERBUFFER_H
+
+#include "datetime.h"
+#include <cstddef>
+#include <cstdio>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+// Text output is built up here and written out in one go, instead of going
+// line by line through std::cout with std::endl flushing each line. A buffer
+// keeps its capacity when cleared or written, so one instance can be reused
+// for many renders.
+class RenderBuffer {
+private:
+    std::string text;
+
+public:
+    enum class Color {
+        Green,
+        Red,
+        Blue
+    };
+
+    RenderBuffer& append(std::string_view value) { text.append(value); return *this; }
+    RenderBuffer& append(char value) { text.push_back(value); return *this; }
+    RenderBuffer& append(std::size_t count, char value) { text.append(count, value); return *this; }
+    RenderBuffer& appendNumber(long long value);
+    // Zero-padded to two digits, as in the month grid.
+    RenderBuffer& appendTwoDigits(int value);
+    // "DD/MM/YYYY (Weekday)", as operator<< writes a Date.
+    RenderBuffer& appendDate(const Date& date);
+    RenderBuffer& appendTime(const Time& time);
+    // Bold ANSI colour; endColor() returns to normal text.
+    RenderBuffer& beginColor(Color color);
+    RenderBuffer& endColor();
+
+    RenderBuffer& operator<<(std::string_view value) { return append(value); }
+    RenderBuffer& operator<<(char value) { return append(value); }
+
+    const std::string& str() const { return text; }
+    std::size_t size() const { return text.size(); }
+    bool empty() const { return text.empty(); }
+    void reserve(std::size_t bytes) { text.reserve(bytes); }
+    void clear() { text.clear(); }
+
+    // Each writes the whole buffer with one call, flushes, and clears it.
+    void writeTo(std::FILE* file);
+    void writeTo(std::ostream& os);
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "rowbitmap.h"
+#include <algorithm>
+#include <bit>
+
+bool RowBitmap::Container::test(std::uint16_t low) const {
+    if (dense()) {
+        return ((words[low / 64] >> (low % 64)) & 1) != 0;
+    }
+    return std::binary_search(values.begin(), values.end(), low);
+}
+
+void RowBitmap::Container::add(std::uint16_t low) {
+    if (dense()) {
+        const std::uint64_t bit = std::uint64_t(1) << (low % 64);
+        if ((words[low / 64] & bit) == 0) {
+            words[low / 64] |= bit;
+            cardinality++;
+        }
+        return;
+    }
+
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) {
+        return;
+    }
+    values.insert(it, low);
+    cardinality++;
+
+    if (values.size() > ARRAY_LIMIT) {
+        words.assign(CHUNK_WORDS, 0);
+        for (std::uint16_t value : values) {
+            words[value / 64] |= std::uint64_t(1) << (value % 64);
+        }
+        std::vector<std::uint16_t>().swap(values);
+    }
+}
+
+void RowBitmap::Container::remove(std::uint16_t low) {
+    if (!dense()) {
+        auto it = std::lower_bound(values.begin(), values.end(), low);
+        if (it != values.end() && *it == low) {
+            values.erase(it);
+            cardinality--;
+        }
+        return;
+    }
+
+    const std::uint64_t bit = std::uint64_t(1) << (low % 64);
+    if ((words[low / 64] & bit) == 0) {
+        return;
+    }
+    words[low / 64] &= ~bit;
+    cardinality--;
+    shrinkIfSparse();
+}
+
+// Half the limit, so a chunk near it does not flip on every change.
+void RowBitmap::Container::shrinkIfSparse() {
+    if (!dense() || cardinality >= ARRAY_LIMIT / 2) {
+        return;
+    }
+    values.reserve(cardinality);
+    for (std::size_t w = 0; w < CHUNK_WORDS; w++) {
+        for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+            values.push_back(static_cast<std::uint16_t>(w * 64 + std::countr_zero(bits)));
+        }
+    }
+    std::vector<std::uint64_t>().swap(words);
+}
+
+// Moves the rows at or above low up by one and returns whether the top row
+// fell off the end of the chunk.
+bool RowBitmap::Container::shiftUp(std::uint16_t low) {
+    if (!dense()) {
+        const std::size_t first = std::lower_bound(values.begin(), values.end(), low) - values.begin();
+        const bool carry = first < values.size() && values.back() == CHUNK_BITS - 1;
+        if (carry) {
+            values.pop_back();
+            cardinality--;
+        }
+        for (std::size_t i = first; i < values.size(); i++) {
+            values[i]++;
+        }
+        return carry;
+    }
+
+    const bool carry = (words[CHUNK_WORDS - 1] >> 63) != 0;
+    const std::size_t first = low / 64;
+    for (std::size_t w = CHUNK_WORDS - 1; w > first; w--) {
+        words[w] = (words[w] << 1) | (words[w - 1] >> 63);
+    }
+    const std::uint64_t keep = (std::uint64_t(1) << (low % 64)) - 1;
+    words[first] = (words[first] & keep) | ((words[first] & ~keep) << 1);
+    if (carry) {
+        cardinality--;
+    }
+    return carry;
+}
+
+// Drops low and moves the rows above it down by one; the top row is left
+// clear for the caller to fill from the next chunk.
+void RowBitmap::Container::shiftDown(std::uint16_t low) {
+    if (!dense()) {
+        auto it = std::lower_bound(values.begin(), values.end(), low);
+        if (it != values.end() && *it == low) {
+            it = values.erase(it);
+            cardinality--;
+        }
+        for (; it != values.end(); ++it) {
+            --*it;
+        }
+        return;
+    }
+
+    if (test(low)) {
+        cardinality--;
+    }
+    const std::size_t first = low / 64;
+    const std::uint64_t keep = (std::uint64_t(1) << (low % 64)) - 1;
+    const std::uint64_t next = first + 1 < CHUNK_WORDS ? words[first + 1] : 0;
+    words[first] = (words[first] & keep) | ((words[first] >> 1) & ~keep) | (next << 63);
+    for (std::size_t w = first + 1; w < CHUNK_WORDS; w++) {
+        words[w] = (words[w] >> 1) | (w + 1 < CHUNK_WORDS ? words[w + 1] << 63 : 0);
+    }
+    shrinkIfSparse();
+}
+
+std::size_t RowBitmap::Container::count(std::size_t from, std::size_t to) const {
+    if (from == 0 && to == CHUNK_BITS) {
+        return cardinality;
+    }
+    if (!dense()) {
+        return std::lower_bound(values.begin(), values.end(), to) -
+            std::lower_bound(values.begin(), values.end(), from);
+    }
+
+    std::size_t total = 0;
+    const std::size_t firstWord = from / 64;
+    const std::size_t lastWord = (to - 1) / 64;
+    for (std::size_t w = firstWord; w <= lastWord; w++) {
+        std::uint64_t bits = words[w];
+        if (w == firstWord) {
+            bits &= ~std::uint64_t(0) << (from % 64);
+        }
+        if (w == lastWord && to % 64 != 0) {
+            bits &= (std::uint64_t(1) << (to % 64)) - 1;
+        }
+        total += std::popcount(bits);
+    }
+    return total;
+}
+
+void RowBitmap::Container::loadWords(std::uint64_t* out, std::size_t firstWord, std::size_t lastWord) const {
+    if (dense()) {
+        std::copy(words.begin() + firstWord, words.begin() + lastWord, out + firstWord);
+        return;
+    }
+    std::fill(out + firstWord, out + lastWord, 0);
+    auto it = std::lower_bound(values.begin(), values.end(), firstWord * 64);
+    for (; it != values.end() && *it < lastWord * 64; ++it) {
+        out[*it / 64] |= std::uint64_t(1) << (*it % 64);
+    }
+}
+
+bool RowBitmap::test(std::size_t row) const {
+    const std::size_t chunk = row / CHUNK_BITS;
+    return chunk < chunks.size() && chunks[chunk].test(static_cast<std::uint16_t>(row % CHUNK_BITS));
+}
+
+void RowBitmap::set(std::size_t row) {
+    const std::size_t chunk = row / CHUNK_BITS;
+    if (chunk >= chunks.size()) {
+        chunks.resize(chunk + 1);
+    }
+    chunks[chunk].add(static_cast<std::uint16_t>(row % CHUNK_BITS));
+}
+
+void RowBitmap::reset(std::size_t row) {
+    const std::size_t chunk = row / CHUNK_BITS;
+    if (chunk < chunks.size()) {
+        chunks[chunk].remove(static_cast<std::uint16_t>(row % CHUNK_BITS));
+    }
+}
+
+void RowBitmap::insert(std::size_t row, bool value) {
+    std::size_t chunk = row / CHUNK_BITS;
+    std::uint16_t low = static_cast<std::uint16_t>(row % CHUNK_BITS);
+    bool carry = value;
+    for (; chunk < chunks.size(); chunk++, low = 0) {
+        const bool out = chunks[chunk].shiftUp(low);
+        if (carry) {
+            chunks[chunk].add(low);
+        }
+        carry = out;
+    }
+    if (carry) {
+        set(chunk * CHUNK_BITS + low);
+    }
+}
+
+void RowBitmap::erase(std::size_t row) {
+    std::size_t chunk = row / CHUNK_BITS;
+    std::uint16_t low = static_cast<std::uint16_t>(row % CHUNK_BITS);
+    for (; chunk < chunks.size(); chunk++, low = 0) {
+        chunks[chunk].shiftDown(low);
+        if (chunk + 1 < chunks.size() && chunks[chunk + 1].test(0)) {
+            chunks[chunk].add(static_cast<std::uint16_t>(CHUNK_BITS - 1));
+        }
+    }
+    while (!chunks.empty() && chunks.back().cardinality == 0) {
+        chunks.pop_back();
+    }
+}
+
+std::size_t RowBitmap::count(std::size_t from, std::size_t to) const {
+    to = std::min(to, chunks.size() * CHUNK_BITS);
+    std::size_t total = 0;
+    while (from < to) {
+        const std::size_t chunk = from / CHUNK_BITS;
+        const std::size_t base = chunk * CHUNK_BITS;
+        const std::size_t end = std::min(to, base + CHUNK_BITS);
+        total += chunks[chunk].count(from - base, end - base);
+        from = end;
+    }
+    return total;
+}
+
+void RowBitmap::loadWords(std::size_t chunk, std::uint64_t* out, std::size_t firstWord, std::size_t lastWord) const {
+    if (chunk < chunks.size()) {
+        chunks[chunk].loadWords(out, firstWord, lastWord);
+    }
+    else {
+        std::fill(out + firstWord, out + lastWord, 0);
+    }
+}
+
+std::size_t RowBitmap::memoryUsage() const {
+    std::size_t bytes = sizeof(*this) + chunks.capacity() * sizeof(Container);
+    for (const Container& container : chunks) {
+        bytes += container.values.capacity() * sizeof(std::uint16_t) +
+            container.words.capacity() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,62 @@
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A compressed set of row numbers, split roaring-style into chunks of 65536
+// rows. A chunk holding few rows stores them as a sorted array of 16-bit
+// offsets; once it passes ARRAY_LIMIT rows it switches to a 1024-word
+// bitmap, and back when it drops below half that. Each chunk caches its
+// cardinality, so counting whole chunks is free.
+//
+// Unlike a plain roaring bitmap it also supports inserting and erasing a row
+// position, which shifts every later row by one, so it can index the rows of
+// a sorted vector that changes in the middle.
+class RowBitmap {
+public:
+    static constexpr std::size_t CHUNK_BITS = 65536;
+    static constexpr std::size_t CHUNK_WORDS = CHUNK_BITS / 64;
+    static constexpr std::size_t ARRAY_LIMIT = 4096;
+
+private:
+    struct Container {
+        std::vector<std::uint16_t> values;  // sorted, while sparse
+        std::vector<std::uint64_t> words;   // CHUNK_WORDS words, once dense
+        std::uint32_t cardinality = 0;
+
+        bool dense() const { return !words.empty(); }
+        bool test(std::uint16_t low) const;
+        void add(std::uint16_t low);
+        void remove(std::uint16_t low);
+        void shrinkIfSparse();
+        bool shiftUp(std::uint16_t low);
+        void shiftDown(std::uint16_t low);
+        std::size_t count(std::size_t from, std::size_t to) const;
+        void loadWords(std::uint64_t* out, std::size_t firstWord, std::size_t lastWord) const;
+    };
+
+    std::vector<Container> chunks;  // chunk i holds rows [i * CHUNK_BITS, (i + 1) * CHUNK_BITS)
+
+public:
+    bool test(std::size_t row) const;
+    void set(std::size_t row);
+    void reset(std::size_t row);
+    void clear() { chunks.clear(); }
+
+    // Moves every row >= row up by one, then sets row if value is true.
+    void insert(std::size_t row, bool value);
+    // Drops row and moves every later row down by one.
+    void erase(std::size_t row);
+
+    std::size_t count(std::size_t from, std::size_t to) const;
+    std::size_t chunkCount() const { return chunks.size(); }
+    // Writes words [firstWord, lastWord) of chunk to the same positions of
+    // out; missing chunks are all zero.
+    void loadWords(std::size_t chunk, std::uint64_t* out, std::size_t firstWord = 0,
+        std::size_t lastWord = CHUNK_WORDS) const;
+    std::size_t memoryUsage() const;
+};
+
+#endif
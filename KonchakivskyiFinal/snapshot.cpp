@@ -0,0 +1,309 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static constexpr char MAGIC[8] = { 'K', 'C', 'A', 'L', 'S', 'N', 'A', 'P' };
+static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+static constexpr std::size_t SECTION_ALIGNMENT = 64;
+
+enum SectionIndex {
+    EVENTS,
+    DAYS,
+    RULES,
+    EXCEPTIONS,
+    STRING_OFFSETS,
+    STRING_DATA,
+    SECTION_COUNT
+};
+
+struct Section {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t checksum;
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t eventCount;
+    std::uint64_t dayCount;
+    std::uint64_t ruleCount;
+    std::uint64_t exceptionCount;
+    std::uint64_t stringCount;
+    std::uint64_t typeCounts[16];
+    std::uint64_t priorityCounts[16];
+    Section sections[SECTION_COUNT];
+    std::uint64_t headerChecksum;  // of the bytes above
+};
+
+static_assert(std::is_trivially_copyable_v<CalendarSnapshot::DayEntry> && sizeof(CalendarSnapshot::DayEntry) == 32);
+
+// Four independent multiply-rotate lanes over 8-byte words, so the loop runs
+// at memory speed. Catches torn writes and bit rot; it is not a cryptographic
+// hash.
+static std::uint64_t checksum(const void* bytes, std::size_t size) {
+    constexpr std::uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    auto round = [](std::uint64_t lane, std::uint64_t word) {
+        lane += word * PRIME2;
+        lane = (lane << 31) | (lane >> 33);
+        return lane * PRIME1;
+    };
+
+    const unsigned char* p = static_cast<const unsigned char*>(bytes);
+    std::uint64_t lanes[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+    std::size_t at = 0;
+    for (; at + 32 <= size; at += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            std::uint64_t word;
+            std::memcpy(&word, p + at + lane * 8, 8);
+            lanes[lane] = round(lanes[lane], word);
+        }
+    }
+    std::uint64_t tail[4] = {};
+    if (size > at) {
+        std::memcpy(tail, p + at, size - at);  // p is null for an empty section
+    }
+    std::uint64_t hash = size;
+    for (int lane = 0; lane < 4; lane++) {
+        hash = round(hash ^ round(lanes[lane], tail[lane]), PRIME1);
+    }
+    hash ^= hash >> 29;
+    hash *= PRIME2;
+    return hash ^ (hash >> 32);
+}
+
+static std::uint64_t headerChecksum(const FileHeader& header) {
+    return checksum(&header, offsetof(FileHeader, headerChecksum));
+}
+
+static std::uint64_t alignUp(std::uint64_t value) {
+    return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+void CalendarSnapshot::save(const Calendar& calendar, const std::string& path) {
+    const CompactEventStore store(calendar);
+    const std::span<const CompactEvent> records = store.getEvents();
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+
+    std::vector<DayEntry> dayIndex;
+    for (std::size_t row = 0; row < records.size(); row++) {
+        const CompactEvent& event = records[row];
+        const std::int32_t day = event.getDate().toDayNumber();
+        if (dayIndex.empty() || dayIndex.back().day != day) {
+            dayIndex.push_back(DayEntry{ day, static_cast<std::uint32_t>(row), DaySummary() });
+        }
+        DaySummary& summary = dayIndex.back().summary;
+        summary.count++;
+        summary.priorityCounts[static_cast<int>(event.getPriority())]++;
+        if (event.getDateTime().hasTime()) {
+            summary.timedCount++;
+        }
+        header.typeCounts[static_cast<int>(event.getType())]++;
+        header.priorityCounts[static_cast<int>(event.getPriority())]++;
+    }
+
+    const StringPool& pool = store.getStrings();
+    std::vector<std::uint64_t> offsets(pool.size() + 1, 0);
+    std::string text;
+    for (std::uint32_t handle = 0; handle < pool.size(); handle++) {
+        text.append(pool.get(handle));
+        offsets[handle + 1] = text.size();
+    }
+
+    header.eventCount = records.size();
+    header.dayCount = dayIndex.size();
+    header.ruleCount = store.getRules().size();
+    header.exceptionCount = store.getExceptionDays().size();
+    header.stringCount = pool.size();
+    const void* contents[SECTION_COUNT] = {
+        records.data(), dayIndex.data(), store.getRules().data(), store.getExceptionDays().data(), offsets.data(),
+        text.data()
+    };
+    const std::uint64_t sizes[SECTION_COUNT] = {
+        records.size_bytes(), dayIndex.size() * sizeof(DayEntry), store.getRules().size_bytes(),
+        store.getExceptionDays().size_bytes(), offsets.size() * sizeof(std::uint64_t), text.size()
+    };
+    std::uint64_t end = sizeof(FileHeader);
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        header.sections[section] = Section{ alignUp(end), sizes[section], checksum(contents[section], sizes[section]) };
+        end = header.sections[section].offset + sizes[section];
+    }
+    header.headerChecksum = headerChecksum(header);
+
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("Unable to create snapshot: " + temporary);
+    }
+    static const char padding[SECTION_ALIGNMENT] = {};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    std::uint64_t at = sizeof(FileHeader);
+    for (int section = 0; section < SECTION_COUNT && written; section++) {
+        const std::size_t gap = static_cast<std::size_t>(header.sections[section].offset - at);
+        written = std::fwrite(padding, 1, gap, file) == gap &&
+            (sizes[section] == 0 || std::fwrite(contents[section], 1, sizes[section], file) == sizes[section]);
+        at = header.sections[section].offset + sizes[section];
+    }
+    written = written && std::fflush(file) == 0;
+#ifdef _WIN32
+    written = written && _commit(_fileno(file)) == 0;
+#else
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporary, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Unable to write snapshot: " + path);
+    }
+#ifndef _WIN32
+    // Make the rename itself durable.
+    const std::filesystem::path directory = std::filesystem::absolute(path).parent_path();
+    const int directoryFd = ::open(directory.c_str(), O_RDONLY);
+    if (directoryFd >= 0) {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+#endif
+}
+
+CalendarSnapshot CalendarSnapshot::open(const std::string& path, Check check) {
+    CalendarSnapshot snapshot;
+    snapshot.file = MappedFile(path);
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(snapshot.file.getData());
+    const std::size_t fileSize = snapshot.file.getSize();
+
+    const std::runtime_error malformed("Malformed snapshot: " + path);
+    FileHeader header;
+    if (fileSize < sizeof(header)) {
+        throw malformed;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byteOrder != BYTE_ORDER_MARK) {
+        throw malformed;
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.headerChecksum != headerChecksum(header)) {
+        throw malformed;
+    }
+
+    const std::uint64_t expected[SECTION_COUNT - 1] = {
+        header.eventCount * sizeof(CompactEvent), header.dayCount * sizeof(DayEntry),
+        header.ruleCount * sizeof(CompactRule), header.exceptionCount * sizeof(std::int32_t),
+        (header.stringCount + 1) * sizeof(std::uint64_t)
+    };
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        const Section& s = header.sections[section];
+        if (s.offset % SECTION_ALIGNMENT != 0 || s.offset > fileSize || s.size > fileSize - s.offset ||
+            (section < SECTION_COUNT - 1 && s.size != expected[section])) {
+            throw malformed;
+        }
+        if (check == Check::Full && checksum(base + s.offset, s.size) != s.checksum) {
+            throw malformed;
+        }
+    }
+    if (header.stringCount == 0 || header.eventCount > UINT32_MAX || header.ruleCount > UINT32_MAX ||
+        header.exceptionCount > UINT32_MAX) {
+        throw malformed;
+    }
+
+    snapshot.events = std::span<const CompactEvent>(
+        reinterpret_cast<const CompactEvent*>(base + header.sections[EVENTS].offset), header.eventCount);
+    snapshot.days = std::span<const DayEntry>(
+        reinterpret_cast<const DayEntry*>(base + header.sections[DAYS].offset), header.dayCount);
+    snapshot.rules = std::span<const CompactRule>(
+        reinterpret_cast<const CompactRule*>(base + header.sections[RULES].offset), header.ruleCount);
+    snapshot.exceptionDays = std::span<const std::int32_t>(
+        reinterpret_cast<const std::int32_t*>(base + header.sections[EXCEPTIONS].offset), header.exceptionCount);
+    snapshot.stringOffsets = std::span<const std::uint64_t>(
+        reinterpret_cast<const std::uint64_t*>(base + header.sections[STRING_OFFSETS].offset), header.stringCount + 1);
+    snapshot.stringData = reinterpret_cast<const char*>(base + header.sections[STRING_DATA].offset);
+    snapshot.stringBytes = header.sections[STRING_DATA].size;
+    for (int value = 0; value < 16; value++) {
+        snapshot.typeCounts[value] = static_cast<std::size_t>(header.typeCounts[value]);
+        snapshot.priorityCounts[value] = static_cast<std::size_t>(header.priorityCounts[value]);
+    }
+    return snapshot;
+}
+
+std::string_view CalendarSnapshot::getString(std::uint32_t handle) const {
+    if (handle + std::size_t(1) >= stringOffsets.size()) {
+        return std::string_view();
+    }
+    const std::uint64_t begin = stringOffsets[handle];
+    const std::uint64_t end = stringOffsets[handle + 1];
+    if (begin > end || end > stringBytes) {
+        return std::string_view();
+    }
+    return std::string_view(stringData + begin, static_cast<std::size_t>(end - begin));
+}
+
+std::size_t CalendarSnapshot::firstDayFrom(const Date& date) const {
+    const std::int32_t day = date.toDayNumber();
+    return std::partition_point(days.begin(), days.end(), [day](const DayEntry& entry) { return entry.day < day; }) -
+        days.begin();
+}
+
+// The row where day entry index starts, clamped so a damaged index cannot
+// reach past the events.
+std::size_t CalendarSnapshot::firstEventOfDay(std::size_t index) const {
+    return index < days.size() ? std::min<std::size_t>(days[index].firstEvent, events.size()) : events.size();
+}
+
+std::span<const CompactEvent> CalendarSnapshot::getEventsByDateRange(const Date& startDate, const Date& endDate) const {
+    if (endDate < startDate) {
+        return {};
+    }
+    const std::size_t first = firstEventOfDay(firstDayFrom(startDate));
+    const std::size_t last = firstEventOfDay(firstDayFrom(endDate + 1));
+    return first < last ? events.subspan(first, last - first) : std::span<const CompactEvent>();
+}
+
+std::span<const CompactEvent> CalendarSnapshot::getEventsByMonth(int month, int year) const {
+    if (!Date::isValidDate(1, month, year)) {
+        return {};
+    }
+    return getEventsByDateRange(Date(1, month, year), Date(Date::daysInMonth(month, year), month, year));
+}
+
+const DaySummary& CalendarSnapshot::getDaySummary(const Date& date) const {
+    static const DaySummary none;
+    const std::size_t index = firstDayFrom(date);
+    return index < days.size() && days[index].day == date.toDayNumber() ? days[index].summary : none;
+}
+
+void CalendarSnapshot::copyTo(Calendar& calendar) const {
+    std::vector<Event> batch;
+    batch.reserve(events.size());
+    for (const CompactEvent& event : events) {
+        batch.push_back(toEvent(event));
+    }
+    calendar.addEvents(batch);
+    for (const CompactRule& rule : rules) {
+        calendar.addRecurringEvent(toEvent(rule.getFirst()), toRule(rule));
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "calendar.h"
+#include "compactevent.h"
+#include "daysummary.h"
+#include "mappedfile.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+// A calendar saved to a binary file and opened again with mmap. The file is
+// the in-memory layout: the events as CompactEvent records in date order, a
+// per-day index of where each day's events start together with its
+// DaySummary, the recurring events as CompactRule records with their
+// exception days, and the interned strings. Opening maps the file and checks the
+// header, so it costs the same for a thousand events as for millions; queries
+// then read the mapped pages directly and only touch the pages they need.
+//
+// The header and every section carry a checksum. open() always checks the
+// header; pass Check::Full to also check the sections, which reads the whole
+// file. String handles and exception runs are bounds-checked on every lookup
+// and out-of-range types and priorities are clamped, so a damaged section
+// gives wrong events or rules, never a read or write out of bounds.
+//
+// The event queries, day summaries and counts cover the single events; the
+// recurring events are only in getRules(), and copyTo() restores them.
+//
+// Files are native byte order; opening a file from a machine of the other
+// byte order fails. The snapshot is read-only: copyTo() loads it into a
+// Calendar to change it. On POSIX systems saving over an open snapshot's file
+// is safe, as the rename leaves the mapped file intact until it is closed.
+class CalendarSnapshot {
+public:
+    static constexpr std::uint32_t VERSION = 2;
+
+    enum class Check {
+        Header,
+        Full
+    };
+
+    // One entry per day that has events, in day order.
+    struct DayEntry {
+        std::int32_t day;
+        std::uint32_t firstEvent;
+        DaySummary summary;
+    };
+
+private:
+    MappedFile file;
+    std::span<const CompactEvent> events;
+    std::span<const DayEntry> days;
+    std::span<const CompactRule> rules;
+    std::span<const std::int32_t> exceptionDays;
+    std::span<const std::uint64_t> stringOffsets;  // stringCount + 1 entries
+    const char* stringData = nullptr;
+    std::size_t stringBytes = 0;
+    std::size_t typeCounts[16] = {};
+    std::size_t priorityCounts[16] = {};
+
+    CalendarSnapshot() = default;
+    // Index of the first day entry on or after date.
+    std::size_t firstDayFrom(const Date& date) const;
+    std::size_t firstEventOfDay(std::size_t index) const;
+    std::string_view getString(std::uint32_t handle) const;
+
+public:
+    // Writes path + ".tmp", syncs it and renames it over path, so readers see
+    // either the old file or the complete new one. Throws std::runtime_error.
+    static void save(const Calendar& calendar, const std::string& path);
+    // Throws std::runtime_error if the file cannot be mapped or fails a check.
+    static CalendarSnapshot open(const std::string& path, Check check = Check::Header);
+
+    std::size_t size() const { return events.size(); }
+    bool empty() const { return events.empty(); }
+    std::size_t getFileSize() const { return file.getSize(); }
+
+    std::span<const CompactEvent> getAllEvents() const { return events; }
+    // The stored events of the same window as the Calendar queries of the
+    // same name. Unlike those they are spans of the mapped records, so they
+    // leave out the occurrences of recurring events; expand getRules() over
+    // the window for those.
+    std::span<const CompactEvent> getEventsByDateRange(const Date& startDate, const Date& endDate) const;
+    std::span<const CompactEvent> getEventsByMonth(int month, int year) const;
+    // The saved summary of the day's single events, not counting recurring
+    // ones as Calendar::getDaySummary does; an empty summary for days without
+    // events.
+    const DaySummary& getDaySummary(const Date& date) const;
+    std::span<const DayEntry> getDays() const { return days; }
+    std::size_t countOfType(EventType type) const { return typeCounts[static_cast<int>(type)]; }
+    std::size_t countOfPriority(EventPriority priority) const { return priorityCounts[static_cast<int>(priority)]; }
+
+    std::string_view getTitle(const CompactEvent& event) const { return getString(event.getTitle()); }
+    std::string_view getDescription(const CompactEvent& event) const { return getString(event.getDescription()); }
+    Event toEvent(const CompactEvent& event) const { return event.toEvent(getTitle(event), getDescription(event)); }
+
+    std::span<const CompactRule> getRules() const { return rules; }
+    // The first occurrence is toEvent(rule.getFirst()).
+    RecurrenceRule toRule(const CompactRule& rule) const { return rule.toRule(exceptionDays); }
+
+    // Adds every event to calendar in one batch, then every recurring event.
+    void copyTo(Calendar& calendar) const;
+};
+
+#endif
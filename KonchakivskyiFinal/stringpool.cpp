@@ -0,0 +1,50 @@
+#include "stringpool.h"
+#include <cstring>
+
+StringPool::StringPool() {
+    strings.push_back(std::string_view());
+    lookup.emplace(std::string_view(), EMPTY);
+}
+
+// Copies value into the arena. Strings over a quarter block get a block of
+// their own, so the current block is not abandoned for them.
+const char* StringPool::store(std::string_view value) {
+    char* out;
+    if (value.size() > BLOCK_SIZE / 4) {
+        blocks.emplace_back(new char[value.size()]);
+        blockBytes += value.size();
+        out = blocks.back().get();
+    }
+    else {
+        if (BLOCK_SIZE - blockUsed < value.size()) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            blockBytes += BLOCK_SIZE;
+            current = blocks.back().get();
+            blockUsed = 0;
+        }
+        out = current + blockUsed;
+        blockUsed += value.size();
+    }
+    std::memcpy(out, value.data(), value.size());
+    return out;
+}
+
+std::uint32_t StringPool::intern(std::string_view value) {
+    auto it = lookup.find(value);
+    if (it != lookup.end()) {
+        return it->second;
+    }
+    const std::uint32_t handle = static_cast<std::uint32_t>(strings.size());
+    const std::string_view stored(store(value), value.size());
+    strings.push_back(stored);
+    lookup.emplace(stored, handle);
+    return handle;
+}
+
+std::size_t StringPool::memoryUsage() const {
+    // Each hash node holds the key, the handle and a next pointer.
+    const std::size_t nodeBytes = sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void*);
+    return sizeof(*this) + blockBytes + blocks.capacity() * sizeof(blocks[0]) +
+        strings.capacity() * sizeof(std::string_view) +
+        lookup.bucket_count() * sizeof(void*) + lookup.size() * nodeBytes;
+}
@@ -0,0 +1,45 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interns strings into large arena blocks and hands out 32-bit handles. Each
+// distinct string is stored once, so a million "Team Meeting" titles cost one
+// copy plus four bytes per use. Strings are never freed individually; the
+// pool only grows until it is destroyed. Handle 0 is always the empty string.
+class StringPool {
+private:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current = nullptr;                // block short strings go into
+    std::size_t blockUsed = BLOCK_SIZE;     // bytes used in current
+    std::size_t blockBytes = 0;             // total bytes allocated in blocks
+    std::vector<std::string_view> strings;  // by handle, pointing into blocks
+    std::unordered_map<std::string_view, std::uint32_t> lookup;
+
+    const char* store(std::string_view value);
+
+public:
+    static constexpr std::uint32_t EMPTY = 0;
+
+    StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    // The handle of an equal string if there is one, else a new handle.
+    std::uint32_t intern(std::string_view value);
+    std::string_view get(std::uint32_t handle) const { return strings[handle]; }
+
+    std::size_t size() const { return strings.size(); }
+    std::size_t memoryUsage() const;
+};
+
+#endif
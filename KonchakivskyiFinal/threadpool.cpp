@@ -0,0 +1,90 @@
+#include "threadpool.h"
+#include <utility>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::runTasks() {
+    for (;;) {
+        const std::size_t task = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= taskCount) {
+            return;
+        }
+        try {
+            (*body)(task);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runTasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++idleWorkers == workers.size()) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& loopBody) {
+    if (count == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &loopBody;
+        taskCount = count;
+        nextTask.store(0, std::memory_order_relaxed);
+        idleWorkers = 0;
+        failure = nullptr;
+        generation++;
+    }
+    wake.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return idleWorkers == workers.size(); });
+    body = nullptr;
+    if (failure) {
+        std::rethrow_exception(std::exchange(failure, nullptr));
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run one parallel loop at a time. The
+// workers live as long as the pool, so a loop costs a wake-up rather than
+// thread creation. Indices are handed out one at a time from a shared
+// counter, so uneven tasks still balance.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(std::size_t)>* body = nullptr;
+    std::size_t taskCount = 0;
+    std::atomic<std::size_t> nextTask{ 0 };
+    std::size_t idleWorkers = 0;
+    std::size_t generation = 0;    // bumped for every loop
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    void workerLoop();
+    void runTasks();
+
+public:
+    // threads == 0 uses std::thread::hardware_concurrency(). The calling
+    // thread also works, so the pool starts threads - 1 workers.
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Runs body(i) for every i in [0, count) and returns once all are done.
+    // If any call throws, the first exception is rethrown here.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+};
+
+#endif
@@ -0,0 +1,370 @@
+#include "timezone.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+static constexpr std::int64_t SECONDS_PER_DAY = 24 * 3600;
+
+static std::int64_t toSeconds(const DateTime& dateTime) {
+    const Time time = dateTime.getTime();
+    return std::int64_t(dateTime.getDate().toDayNumber()) * SECONDS_PER_DAY +
+        time.getHour() * 3600 + time.getMinute() * 60 + time.getSecond();
+}
+
+static DateTime fromSeconds(std::int64_t seconds) {
+    std::int64_t days = seconds / SECONDS_PER_DAY;
+    std::int64_t secondOfDay = seconds % SECONDS_PER_DAY;
+    if (secondOfDay < 0) {
+        secondOfDay += SECONDS_PER_DAY;
+        days--;
+    }
+    const int s = static_cast<int>(secondOfDay);
+    return DateTime(Date::fromDayNumber(static_cast<int>(days)), Time(s / 3600, s / 60 % 60, s % 60));
+}
+
+// Big-endian readers over the raw file contents.
+static std::int64_t readBigEndian(const unsigned char* data, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | data[i];
+    }
+    if (bytes < 8 && (value & (std::uint64_t(1) << (bytes * 8 - 1)))) {
+        value |= ~std::uint64_t(0) << (bytes * 8);
+    }
+    return static_cast<std::int64_t>(value);
+}
+
+TimeZone TimeZone::loadFile(const std::string& name, const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open time zone: " + name);
+    }
+    const std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const std::size_t headerSize = 44;
+    const std::runtime_error malformed("Malformed time zone file: " + name);
+    if (data.size() < headerSize || data[0] != 'T' || data[1] != 'Z' || data[2] != 'i' || data[3] != 'f') {
+        throw malformed;
+    }
+
+    struct Counts {
+        std::size_t isUtc, isStd, leap, time, type, chars;
+    };
+    auto readCounts = [&data](std::size_t at) {
+        const unsigned char* p = data.data() + at + 20;
+        return Counts{
+            static_cast<std::size_t>(readBigEndian(p, 4)), static_cast<std::size_t>(readBigEndian(p + 4, 4)),
+            static_cast<std::size_t>(readBigEndian(p + 8, 4)), static_cast<std::size_t>(readBigEndian(p + 12, 4)),
+            static_cast<std::size_t>(readBigEndian(p + 16, 4)), static_cast<std::size_t>(readBigEndian(p + 20, 4))
+        };
+    };
+    auto blockSize = [](const Counts& c, std::size_t timeSize) {
+        return c.time * timeSize + c.time + c.type * 6 + c.chars + c.leap * (timeSize + 4) + c.isStd + c.isUtc;
+    };
+
+    // Version 2+ files repeat the data with 64-bit times after the v1 block.
+    const char version = static_cast<char>(data[4]);
+    std::size_t at = 0;
+    std::size_t timeSize = 4;
+    Counts counts = readCounts(0);
+    if (version >= '2') {
+        at = headerSize + blockSize(counts, 4);
+        if (data.size() < at + headerSize) {
+            throw malformed;
+        }
+        counts = readCounts(at);
+        timeSize = 8;
+    }
+    at += headerSize;
+    if (counts.type == 0 || data.size() < at + blockSize(counts, timeSize)) {
+        throw malformed;
+    }
+
+    TimeZone zone;
+    zone.name = name;
+
+    const unsigned char* p = data.data() + at;
+    zone.transitions.resize(counts.time);
+    for (std::size_t i = 0; i < counts.time; i++, p += timeSize) {
+        zone.transitions[i] = readBigEndian(p, static_cast<int>(timeSize));
+    }
+    zone.transitionTypes.assign(p, p + counts.time);
+    p += counts.time;
+    zone.types.resize(counts.type);
+    for (std::size_t i = 0; i < counts.type; i++, p += 6) {
+        zone.types[i].utcOffset = static_cast<std::int32_t>(readBigEndian(p, 4));
+        zone.types[i].isDst = p[4] != 0;
+    }
+    for (std::uint8_t type : zone.transitionTypes) {
+        if (type >= counts.type) {
+            throw malformed;
+        }
+    }
+
+    if (timeSize == 8) {
+        const std::size_t footer = at + blockSize(counts, timeSize);
+        if (footer < data.size() && data[footer] == '\n') {
+            const auto begin = data.begin() + footer + 1;
+            const auto end = std::find(begin, data.end(), '\n');
+            if (end != data.end() && begin != end) {
+                zone.hasRule = parsePosixRule(std::string(begin, end), zone.rule);
+            }
+        }
+    }
+    return zone;
+}
+
+// Parses "[+-]hh[:mm[:ss]]" into seconds.
+static bool parseRuleTime(const char*& it, const char* end, std::int32_t& seconds) {
+    int sign = 1;
+    if (it != end && (*it == '+' || *it == '-')) {
+        sign = *it == '-' ? -1 : 1;
+        ++it;
+    }
+    int parts[3] = { 0, 0, 0 };
+    for (int i = 0; i < 3; i++) {
+        int value = 0;
+        if (!detail::parseNumberField(it, end, i == 0 ? 3 : 2, value)) {
+            return false;
+        }
+        parts[i] = value;
+        if (i == 2 || !detail::parseSeparator(it, end, ':')) {
+            break;
+        }
+    }
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return true;
+}
+
+static bool skipZoneAbbreviation(const char*& it, const char* end) {
+    if (it != end && *it == '<') {
+        while (it != end && *it != '>') {
+            ++it;
+        }
+        return detail::parseSeparator(it, end, '>');
+    }
+    const char* start = it;
+    while (it != end && ((*it >= 'A' && *it <= 'Z') || (*it >= 'a' && *it <= 'z'))) {
+        ++it;
+    }
+    return it - start >= 3;
+}
+
+bool TimeZone::parsePosixRule(const std::string& text, PosixRule& result) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    PosixRule rule;
+
+    // POSIX offsets count hours west of Greenwich, the opposite sign to ours.
+    std::int32_t offset = 0;
+    if (!skipZoneAbbreviation(it, end) || !parseRuleTime(it, end, offset)) {
+        return false;
+    }
+    rule.stdOffset = -offset;
+
+    if (it != end) {
+        if (!skipZoneAbbreviation(it, end)) {
+            return false;
+        }
+        rule.hasDst = true;
+        rule.dstOffset = rule.stdOffset + 3600;
+        if (it != end && *it != ',') {
+            if (!parseRuleTime(it, end, offset)) {
+                return false;
+            }
+            rule.dstOffset = -offset;
+        }
+
+        PosixRule::Change* changes[] = { &rule.dstStart, &rule.dstEnd };
+        for (PosixRule::Change* change : changes) {
+            if (!detail::parseSeparator(it, end, ',')) {
+                return false;
+            }
+            if (detail::parseSeparator(it, end, 'M')) {
+                change->kind = PosixRule::Kind::MonthWeekDay;
+                if (!detail::parseNumberField(it, end, 2, change->month) || !detail::parseSeparator(it, end, '.') ||
+                    !detail::parseNumberField(it, end, 1, change->week) || !detail::parseSeparator(it, end, '.') ||
+                    !detail::parseNumberField(it, end, 1, change->day) ||
+                    change->month < 1 || change->month > 12 || change->week < 1 || change->week > 5 || change->day > 6) {
+                    return false;
+                }
+            }
+            else {
+                change->kind = detail::parseSeparator(it, end, 'J') ? PosixRule::Kind::JulianNoLeap : PosixRule::Kind::ZeroBasedDay;
+                if (!detail::parseNumberField(it, end, 3, change->day) || change->day > 365 ||
+                    (change->kind == PosixRule::Kind::JulianNoLeap && change->day < 1)) {
+                    return false;
+                }
+            }
+            if (detail::parseSeparator(it, end, '/') && !parseRuleTime(it, end, change->secondsAfterMidnight)) {
+                return false;
+            }
+        }
+    }
+
+    if (it != end) {
+        return false;
+    }
+    result = rule;
+    return true;
+}
+
+// Local wall-clock second, in the offset in effect before the change, at
+// which the change happens in the given year. Day numbers are computed
+// directly, since transitions can fall outside the years Date accepts.
+std::int64_t TimeZone::changeToLocalSeconds(const PosixRule::Change& change, int year) {
+    int dayNumber = Date::dayNumberOf(1, 1, year);
+    switch (change.kind) {
+    case PosixRule::Kind::JulianNoLeap:
+        dayNumber += change.day - 1 + (Date::isLeapYear(year) && change.day >= 60 ? 1 : 0);
+        break;
+    case PosixRule::Kind::ZeroBasedDay:
+        dayNumber += change.day;
+        break;
+    case PosixRule::Kind::MonthWeekDay: {
+        const Date first = Date::fromDayNumber(Date::dayNumberOf(1, change.month, year));
+        int day = 1 + (change.day - first.getDayOfWeekNumber() + 7) % 7 + (change.week - 1) * 7;
+        while (day > Date::daysInMonth(change.month, year)) {
+            day -= 7;
+        }
+        dayNumber = first.toDayNumber() + day - 1;
+        break;
+    }
+    }
+    return std::int64_t(dayNumber) * SECONDS_PER_DAY + change.secondsAfterMidnight;
+}
+
+std::int32_t TimeZone::ruleOffsetAt(std::int64_t utcSeconds) const {
+    if (!rule.hasDst) {
+        return rule.stdOffset;
+    }
+
+    std::int64_t localDays = (utcSeconds + rule.stdOffset) / SECONDS_PER_DAY;
+    if ((utcSeconds + rule.stdOffset) % SECONDS_PER_DAY < 0) {
+        localDays--;
+    }
+    const int year = Date::fromDayNumber(static_cast<int>(localDays)).getYear();
+
+    const std::int64_t start = changeToLocalSeconds(rule.dstStart, year) - rule.stdOffset;
+    const std::int64_t end = changeToLocalSeconds(rule.dstEnd, year) - rule.dstOffset;
+    const bool inDst = start < end
+        ? (utcSeconds >= start && utcSeconds < end)
+        : (utcSeconds < end || utcSeconds >= start);
+    return inDst ? rule.dstOffset : rule.stdOffset;
+}
+
+std::int32_t TimeZone::utcOffsetAt(std::int64_t utcSeconds) const {
+    if (transitions.empty() || utcSeconds < transitions.front()) {
+        if (transitions.empty() && hasRule) {
+            return ruleOffsetAt(utcSeconds);
+        }
+        return types.front().utcOffset;
+    }
+    if (utcSeconds >= transitions.back() && hasRule) {
+        return ruleOffsetAt(utcSeconds);
+    }
+
+    const auto next = std::upper_bound(transitions.begin(), transitions.end(), utcSeconds);
+    return types[transitionTypes[(next - transitions.begin()) - 1]].utcOffset;
+}
+
+DateTime TimeZone::toLocal(const DateTime& utcDateTime) const {
+    if (!utcDateTime.hasTime()) {
+        return utcDateTime;
+    }
+    const std::int64_t seconds = toSeconds(utcDateTime);
+    return fromSeconds(seconds + utcOffsetAt(seconds));
+}
+
+DateTime TimeZone::toUtc(const DateTime& localDateTime) const {
+    if (!localDateTime.hasTime()) {
+        return localDateTime;
+    }
+    const std::int64_t local = toSeconds(localDateTime);
+    const std::int64_t guess = local - utcOffsetAt(local);
+    return fromSeconds(local - utcOffsetAt(guess));
+}
+
+DateTime TimeZone::convert(const DateTime& dateTime, const TimeZone& from, const TimeZone& to) {
+    return to.toLocal(from.toUtc(dateTime));
+}
+
+DateTime TimeZone::now() const {
+    return toLocal(fromSeconds(static_cast<std::int64_t>(std::time(nullptr))));
+}
+
+Date TimeZone::today() const {
+    return now().getDate();
+}
+
+static std::mutex registryMutex;
+static std::map<std::string, std::unique_ptr<TimeZone>> registry;
+
+static std::string zoneinfoDirectory() {
+    const char* dir = std::getenv("TZDIR");
+    return dir && *dir ? dir : "/usr/share/zoneinfo";
+}
+
+const TimeZone& TimeZone::get(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto it = registry.find(name);
+    if (it != registry.end()) {
+        return *it->second;
+    }
+    if (name.empty() || name.find("..") != std::string::npos) {
+        throw std::runtime_error("Invalid time zone name: " + name);
+    }
+
+    const std::string path = name[0] == '/' ? name : zoneinfoDirectory() + "/" + name;
+    std::unique_ptr<TimeZone> zone(new TimeZone(loadFile(name, path)));
+    return *registry.emplace(name, std::move(zone)).first->second;
+}
+
+const TimeZone& TimeZone::utc() {
+    static const TimeZone zone = [] {
+        TimeZone result;
+        result.name = "UTC";
+        result.types.push_back(LocalTimeType{ 0, false });
+        return result;
+    }();
+    return zone;
+}
+
+const TimeZone& TimeZone::local() {
+    static const TimeZone& zone = []() -> const TimeZone& {
+        const char* tz = std::getenv("TZ");
+        if (tz && *tz) {
+            const std::string name = tz[0] == ':' ? tz + 1 : tz;
+            try {
+                return get(name);
+            }
+            catch (const std::runtime_error&) {
+            }
+
+            PosixRule rule;
+            if (parsePosixRule(name, rule)) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                std::unique_ptr<TimeZone> zone(new TimeZone());
+                zone->name = name;
+                zone->types.push_back(LocalTimeType{ rule.stdOffset, false });
+                zone->hasRule = true;
+                zone->rule = rule;
+                return *registry.emplace(":" + name, std::move(zone)).first->second;
+            }
+        }
+        try {
+            return get("/etc/localtime");
+        }
+        catch (const std::runtime_error&) {
+            return utc();
+        }
+    }();
+    return zone;
+}
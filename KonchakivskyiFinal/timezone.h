@@ -0,0 +1,78 @@
+#ifndef TIMEZONE_H
+#define TIMEZONE_H
+
+#include "datetime.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A time zone loaded from a TZif file (RFC 8536) in the system zoneinfo
+// database. Zones are parsed once and cached for the lifetime of the process;
+// conversions only read the cached tables, so they are reentrant and never
+// allocate. Instants after the last stored transition follow the POSIX TZ
+// rule from the file footer.
+class TimeZone {
+private:
+    struct LocalTimeType {
+        std::int32_t utcOffset;
+        bool isDst;
+    };
+
+    // POSIX TZ rule, e.g. "EET-2EEST,M3.5.0/3,M10.5.0/4".
+    struct PosixRule {
+        enum class Kind { JulianNoLeap, ZeroBasedDay, MonthWeekDay };
+
+        struct Change {
+            Kind kind = Kind::MonthWeekDay;
+            int day = 0;
+            int week = 0;
+            int month = 0;
+            std::int32_t secondsAfterMidnight = 7200;
+        };
+
+        std::int32_t stdOffset = 0;
+        std::int32_t dstOffset = 0;
+        bool hasDst = false;
+        Change dstStart;
+        Change dstEnd;
+    };
+
+    std::string name;
+    std::vector<std::int64_t> transitions;
+    std::vector<std::uint8_t> transitionTypes;
+    std::vector<LocalTimeType> types;
+    bool hasRule = false;
+    PosixRule rule;
+
+    TimeZone() = default;
+
+    static TimeZone loadFile(const std::string& name, const std::string& path);
+    static bool parsePosixRule(const std::string& text, PosixRule& result);
+    static std::int64_t changeToLocalSeconds(const PosixRule::Change& change, int year);
+    std::int32_t ruleOffsetAt(std::int64_t utcSeconds) const;
+
+public:
+    // Looks the zone up in $TZDIR or /usr/share/zoneinfo, e.g. "Europe/Kyiv".
+    // Throws std::runtime_error if the zone cannot be found or parsed.
+    static const TimeZone& get(const std::string& name);
+    static const TimeZone& utc();
+    // The zone named by $TZ, else /etc/localtime, else UTC.
+    static const TimeZone& local();
+
+    const std::string& getName() const { return name; }
+
+    // Offset from UTC in seconds that applies at the given instant.
+    std::int32_t utcOffsetAt(std::int64_t utcSeconds) const;
+
+    // All-day values carry no time of day and are returned unchanged. Local
+    // times skipped or repeated by a transition use one of the two offsets
+    // around it.
+    DateTime toLocal(const DateTime& utcDateTime) const;
+    DateTime toUtc(const DateTime& localDateTime) const;
+    static DateTime convert(const DateTime& dateTime, const TimeZone& from, const TimeZone& to);
+
+    Date today() const;
+    DateTime now() const;
+};
+
+#endif